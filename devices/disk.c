@@ -86,7 +86,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -226,7 +226,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer)
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sector (d, sec_no, 1);
   issue_pio_command (c, CMD_READ_SECTOR_RETRY);
   sema_down (&c->completion_wait);
   if (!wait_while_busy (d))
@@ -251,7 +251,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sector (d, sec_no, 1);
   issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
   if (!wait_while_busy (d))
     PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
@@ -260,6 +260,103 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
   d->write_cnt++;
   lock_release (&c->lock);
 }
+
+/* Reads the CNT sectors starting at SEC_NO from disk D into
+   BUFFER, which must have room for CNT * DISK_SECTOR_SIZE bytes,
+   with a single READ SECTOR command.  CNT must be between 1 and
+   DISK_MULTIPLE_MAX.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+                    void *buffer) 
+{
+  struct channel *c;
+  size_t i;
+  
+  ASSERT (d != NULL);
+  ASSERT (buffer != NULL);
+  ASSERT (cnt >= 1 && cnt <= DISK_MULTIPLE_MAX);
+
+  c = d->channel;
+  lock_acquire (&c->lock);
+  select_sector (d, sec_no, cnt);
+  issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+  for (i = 0; i < cnt; i++) 
+    {
+      /* The disk interrupts once each sector is ready. */
+      sema_down (&c->completion_wait);
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk read failed, sector=%"PRDSNu,
+               d->name, sec_no + i);
+      if (i + 1 < cnt)
+        c->expecting_interrupt = true;
+      input_sector (c, (uint8_t *) buffer + i * DISK_SECTOR_SIZE);
+    }
+  d->read_cnt += cnt;
+  lock_release (&c->lock);
+}
+
+/* Writes the CNT sectors starting at SEC_NO to disk D from
+   BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes, with
+   a single WRITE SECTOR command.  CNT must be between 1 and
+   DISK_MULTIPLE_MAX.  Returns after the disk has acknowledged
+   receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multiple (struct disk *d, disk_sector_t sec_no, size_t cnt,
+                     const void *buffer)
+{
+  ASSERT (buffer != NULL);
+
+  disk_write_vector (d, sec_no, &buffer, 1, cnt);
+}
+
+/* Writes BUF_CNT buffers to disk D, one after another starting at
+   sector SEC_NO, with a single WRITE SECTOR command.  Each of
+   BUFFERS[] must contain BUF_SECTORS * DISK_SECTOR_SIZE bytes,
+   and BUF_CNT * BUF_SECTORS must be between 1 and
+   DISK_MULTIPLE_MAX.  Returns after the disk has acknowledged
+   receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_vector (struct disk *d, disk_sector_t sec_no,
+                   const void *const *buffers, size_t buf_cnt,
+                   size_t buf_sectors)
+{
+  struct channel *c;
+  size_t cnt = buf_cnt * buf_sectors;
+  size_t i;
+  
+  ASSERT (d != NULL);
+  ASSERT (buffers != NULL);
+  ASSERT (buf_sectors >= 1);
+  ASSERT (cnt >= 1 && cnt <= DISK_MULTIPLE_MAX);
+
+  c = d->channel;
+  lock_acquire (&c->lock);
+  select_sector (d, sec_no, cnt);
+  issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
+  for (i = 0; i < cnt; i++) 
+    {
+      const uint8_t *buffer = buffers[i / buf_sectors];
+
+      ASSERT (buffer != NULL);
+
+      /* The disk interrupts once it has taken each sector. */
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk write failed, sector=%"PRDSNu,
+               d->name, sec_no + i);
+      output_sector (c, buffer + i % buf_sectors * DISK_SECTOR_SIZE);
+      sema_down (&c->completion_wait);
+      if (i + 1 < cnt)
+        c->expecting_interrupt = true;
+    }
+  d->write_cnt += cnt;
+  lock_release (&c->lock);
+}
 
 /* Disk detection and identification. */
 
@@ -426,18 +523,19 @@ print_ata_string (char *string, size_t size)
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the count CNT of sectors from there to the
+   disk's sector selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) 
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) 
 {
   struct channel *c = d->channel;
 
-  ASSERT (sec_no < d->capacity);
-  ASSERT (sec_no < (1UL << 28));
+  ASSERT (cnt >= 1 && cnt <= DISK_MULTIPLE_MAX);
+  ASSERT (sec_no + cnt <= d->capacity);
+  ASSERT (sec_no + cnt <= (1UL << 28));
   
   select_device_wait (d);
-  outb (reg_nsect (c), 1);
+  outb (reg_nsect (c), cnt & 0xff);     /* 0 means 256. */
   outb (reg_lbal (c), sec_no);
   outb (reg_lbam (c), sec_no >> 8);
   outb (reg_lbah (c), (sec_no >> 16));
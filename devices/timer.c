@@ -17,17 +17,83 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, and that divided by TIMER_FREQ, rounded
+   to nearest: the count of one timer tick. */
+#define PIT_FREQ 1193180
+#define PIT_TICK ((PIT_FREQ + TIMER_FREQ / 2) / TIMER_FREQ)
+#define NS_PER_TICK (1000 * 1000 * 1000 / TIMER_FREQ)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Tickless idle.  If true, set by kernel command-line option
+   "-tickless", the idle thread programs the 8254 for one
+   interrupt at the next timeout instead of one per tick.  The
+   8254 count is 16 bits, so a one-shot lasts at most 65535
+   counts, about 55 ms: it reaches TICKLESS_MAX tick boundaries,
+   the first being the end of the current tick, and saves at most
+   TICKLESS_MAX - 1 = 4 interrupts.  A longer idle period wakes up
+   every TICKLESS_MAX ticks on the way. */
+bool timer_tickless;
+#define TICKLESS_MAX (0xffff / PIT_TICK)
+static int oneshot_ticks;       /* Ticks the one-shot covers, or 0. */
+static uint16_t oneshot_count;  /* Count the one-shot started from. */
+static long long suppressed_ticks; /* # of ticks without interrupt. */
+
+/* Hierarchical timer wheel of pending timeouts.  Level 0 has a
+   slot for each of the next 256 ticks, and each higher level a
+   slot for each of 64 spans of the whole level below, so that
+   five levels reach 2**32 ticks ahead.  Adding and canceling a
+   timeout take constant time, and a tick runs one level 0 slot;
+   once every 256 ticks a slot of a higher level is cascaded,
+   that is, its timeouts are added again into the levels below. */
+#define WHEEL_BITS0 8                   /* Level 0 index bits. */
+#define WHEEL_BITS 6                    /* Higher level index bits. */
+#define WHEEL_LEVELS 5                  /* Number of levels. */
+#define WHEEL_SLOTS0 (1 << WHEEL_BITS0)
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_SPAN(LEVEL) ((int64_t) 1 << (WHEEL_BITS0 + (LEVEL) * WHEEL_BITS))
+
+static struct list wheel0[WHEEL_SLOTS0];
+static struct list wheel[WHEEL_LEVELS - 1][WHEEL_SLOTS];
+static int64_t wheel_now;       /* Next tick whose slot has not run. */
+
+/* Sub-tick timeouts.  A timeout added by timeout_add_ns() waits
+   on the wheel for the tick its deadline falls in, then here, by
+   deadline.  While any are here, counter 0 of the 8254 runs a
+   chain of one-shots: one to each deadline, and the last to the
+   next tick boundary, where it goes back to periodic mode. */
+static struct list subtick_list;
+static bool subtick_armed;      /* Counter 0 in sub-tick one-shot? */
+static uint16_t subtick_count;  /* Count the one-shot started from. */
+static uint16_t subtick_rest;   /* Count from its end to the tick. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time stamp counter clock.  Its rate is measured against the
+   8254 by timer_calibrate(); until then clock_ns() counts in
+   whole ticks. */
+#define TSC_CALIBRATE_TICKS 4   /* Ticks to measure the rate over. */
+static uint64_t tsc_freq;       /* TSC increments per second, or 0. */
+static uint64_t tsc_base;       /* TSC at tick TICKS_BASE. */
+static int64_t ticks_base;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void sleep_until_ns (int64_t deadline);
+static void wheel_insert (struct timeout *);
+static void wheel_run (int64_t now);
+static timeout_func wake_sleeper;
+static void run_tick (void);
+static void pit_program (uint8_t mode, uint16_t count);
+static uint16_t pit_read (void);
+static void subtick_insert (struct timeout *);
+static void subtick_arm (uint16_t left);
+static void subtick_interrupt (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -35,13 +101,16 @@ static void real_time_sleep (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
-  /* 8254 input frequency divided by TIMER_FREQ, rounded to
-     nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+  int level, slot;
 
-  outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-  outb (0x40, count & 0xff);
-  outb (0x40, count >> 8);
+  for (slot = 0; slot < WHEEL_SLOTS0; slot++)
+    list_init (&wheel0[slot]);
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      list_init (&wheel[level][slot]);
+  list_init (&subtick_list);
+
+  pit_program (0x34, PIT_TICK);  /* Counter 0, mode 2: periodic. */
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -70,6 +139,53 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  /* Time the TSC over whole ticks, from one tick boundary to
+     another. */
+  {
+    int64_t start = ticks;
+    uint64_t tsc;
+
+    while (ticks == start)
+      barrier ();
+    start = ticks;
+    tsc = timer_tsc ();
+    while (ticks - start < TSC_CALIBRATE_TICKS)
+      barrier ();
+    tsc_freq = (timer_tsc () - tsc) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+    tsc_base = tsc;
+    ticks_base = start;
+  }
+  printf ("TSC runs at %'"PRIu64" Hz.\n", tsc_freq);
+}
+
+/* Returns the time stamp counter, the CPU's cycle count. */
+uint64_t
+timer_tsc (void) 
+{
+  uint32_t lo, hi;
+
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Returns the nanoseconds since the OS booted, from the time stamp
+   counter once timer_calibrate() has measured it.  Tick K starts
+   at about K * 1e9 / TIMER_FREQ. */
+int64_t
+clock_ns (void) 
+{
+  uint64_t cycles;
+
+  if (tsc_freq == 0)
+    return timer_ticks () * (1000 * 1000 * 1000 / TIMER_FREQ);
+
+  /* Split into seconds and the rest, so that no product
+     overflows. */
+  cycles = timer_tsc () - tsc_base;
+  return (ticks_base * (1000 * 1000 * 1000 / TIMER_FREQ)
+          + (int64_t) (cycles / tsc_freq) * 1000 * 1000 * 1000
+          + (int64_t) (cycles % tsc_freq * 1000 * 1000 * 1000 / tsc_freq));
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -95,15 +211,30 @@ timer_elapsed (int64_t then)
 void
 timer_sleep (int64_t tick) 
 {
- int64_t start = timer_ticks ();
+  int64_t start = timer_ticks ();
+  struct timeout to;
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
- // while (timer_elapsed (start) < ticks) 
-  if( ticks <=0 )
-    thread_yield ();
-  else{
-    push2sleep(tick+start);
-  }
+  if (tick <= 0)
+    {
+      thread_yield ();
+      return;
+    }
+
+  /* Block until a timeout on our stack wakes us up. */
+  timeout_init (&to, wake_sleeper, thread_current ());
+  old_level = intr_disable ();
+  timeout_add (&to, start + tick);
+  thread_block ();
+  intr_set_level (old_level);
+}
+
+/* Wakes up the thread sleeping in timer_sleep(). */
+static void
+wake_sleeper (void *t) 
+{
+  thread_unblock (t);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -132,16 +263,398 @@ void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Tickless: %lld ticks suppressed in idle\n", suppressed_ticks);
+}
+
+/* Called by the idle thread, with interrupts off, right before it
+   halts.  If nothing is due on the next tick, programs the 8254
+   for a single interrupt on the tick of the next timeout, at most
+   TICKLESS_MAX ticks ahead. */
+void
+timer_idle_enter (void) 
+{
+  int n;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  if (!timer_tickless || oneshot_ticks != 0 || subtick_armed)
+    return;
+
+  /* Tick N from now is the first with a timeout in its level 0
+     slot, or a cascade that may bring one. */
+  for (n = 1; n < TICKLESS_MAX; n++)
+    {
+      int64_t t = ticks + n;
+      if ((t & (WHEEL_SLOTS0 - 1)) == 0
+          || !list_empty (&wheel0[t & (WHEEL_SLOTS0 - 1)]))
+        break;
+    }
+  if (n < 2)
+    return;
+
+  /* Start from what is left of the current tick, so that the
+     interrupt falls on a tick boundary. */
+  oneshot_ticks = n;
+  oneshot_count = pit_read () + (n - 1) * PIT_TICK;
+  pit_program (0x30, oneshot_count);    /* Counter 0, mode 0: one-shot. */
+}
+
+/* Called at the start of each external interrupt.  If the idle
+   thread armed a one-shot, runs the ticks whose boundaries passed
+   without an interrupt and puts the 8254 back on tick boundaries:
+   a one-shot to the next boundary, where it goes back to periodic
+   mode as after a sub-tick one-shot, so that the wakeup does not
+   shift the ticks.  The last tick of the one-shot is left to its
+   own interrupt, which is pending if the count ran out. */
+void
+timer_idle_exit (void) 
+{
+  uint16_t remaining, left;
+  int ahead, passed;
+
+  ASSERT (intr_context ());
+  if (oneshot_ticks == 0)
+    return;
+
+  /* Once it runs out, the count wraps around to 0xffff, above
+     anything the one-shot started from.  Otherwise the boundaries
+     still ahead, the last one included, are every PIT_TICK counts
+     back from the end of the one-shot. */
+  remaining = pit_read ();
+  if (remaining == 0 || remaining > oneshot_count)
+    {
+      passed = oneshot_ticks - 1;
+      left = PIT_TICK;
+    }
+  else
+    {
+      ahead = DIV_ROUND_UP (remaining, PIT_TICK);
+      passed = oneshot_ticks - ahead;
+      left = remaining - (ahead - 1) * PIT_TICK;
+    }
+  oneshot_ticks = 0;
+
+  if (left < PIT_TICK)
+    {
+      subtick_rest = 0;
+      subtick_arm (left);
+    }
+  else
+    pit_program (0x34, PIT_TICK);
+
+  suppressed_ticks += passed;
+  while (passed-- > 0)
+    run_tick ();
+}
+
+/* Writes control word MODE for 8254 counter 0 and then COUNT. */
+static void
+pit_program (uint8_t mode, uint16_t count) 
+{
+  outb (0x43, mode);    /* CW: counter 0, LSB then MSB, MODE, binary. */
+  outb (0x40, count & 0xff);
+  outb (0x40, count >> 8);
+}
+
+/* Returns the current count of 8254 counter 0. */
+static uint16_t
+pit_read (void) 
+{
+  uint8_t lo, hi;
+
+  outb (0x43, 0x00);    /* CW: counter 0, latch count. */
+  lo = inb (0x40);
+  hi = inb (0x40);
+  return lo | (hi << 8);
 }
 
+/* Initializes TO to call FUNC with AUX once it expires. */
+void
+timeout_init (struct timeout *to, timeout_func *func, void *aux) 
+{
+  ASSERT (to != NULL);
+  ASSERT (func != NULL);
+
+  to->func = func;
+  to->aux = aux;
+  to->deadline = 0;
+  to->pending = false;
+}
+
+/* Arranges for TO to run in the timer interrupt of tick EXPIRES,
+   or the next tick if EXPIRES has passed.  TO must not be
+   pending. */
+void
+timeout_add (struct timeout *to, int64_t expires) 
+{
+  enum intr_level old_level;
+
+  ASSERT (to != NULL);
+  ASSERT (!to->pending);
+
+  old_level = intr_disable ();
+  to->expires = expires;
+  to->deadline = 0;
+  to->pending = true;
+  wheel_insert (to);
+  intr_set_level (old_level);
+}
+
+/* Arranges for TO to run once clock_ns() reaches DEADLINE, from
+   the interrupt of a one-shot of the 8254 if DEADLINE falls
+   between two ticks.  TO must not be pending. */
+void
+timeout_add_ns (struct timeout *to, int64_t deadline) 
+{
+  enum intr_level old_level;
+
+  ASSERT (to != NULL);
+  ASSERT (!to->pending);
+  ASSERT (deadline > 0);
+
+  old_level = intr_disable ();
+  to->expires = deadline / NS_PER_TICK;
+  to->deadline = deadline;
+  to->pending = true;
+  if (to->expires > ticks)
+    wheel_insert (to);
+  else
+    subtick_insert (to);
+  intr_set_level (old_level);
+}
+
+/* Cancels TO.  Returns true if it was pending, false if it
+   already ran or was never added. */
+bool
+timeout_cancel (struct timeout *to) 
+{
+  enum intr_level old_level;
+  bool pending;
+
+  ASSERT (to != NULL);
+
+  old_level = intr_disable ();
+  pending = to->pending;
+  if (pending)
+    {
+      list_remove (&to->elem);
+      to->pending = false;
+    }
+  intr_set_level (old_level);
+  return pending;
+}
+
+/* Puts TO in the wheel slot for its expiry.  Interrupts must be
+   off. */
+static void
+wheel_insert (struct timeout *to) 
+{
+  int64_t expires = to->expires;
+  int64_t delta = expires - wheel_now;
+  struct list *slot;
+  int level;
+
+  if (delta < 0)
+    slot = &wheel0[wheel_now & (WHEEL_SLOTS0 - 1)];
+  else if (delta < WHEEL_SLOTS0)
+    slot = &wheel0[expires & (WHEEL_SLOTS0 - 1)];
+  else
+    {
+      /* Past the reach of the wheel, park it in the last slot it
+         reaches; it is put back in the right one when cascaded. */
+      if (delta >= WHEEL_SPAN (WHEEL_LEVELS - 1))
+        {
+          delta = WHEEL_SPAN (WHEEL_LEVELS - 1) - 1;
+          expires = wheel_now + delta;
+        }
+      for (level = 1; delta >= WHEEL_SPAN (level); level++)
+        continue;
+      slot = &wheel[level - 1][(expires >> (WHEEL_BITS0 + (level - 1)
+                                            * WHEEL_BITS))
+                               & (WHEEL_SLOTS - 1)];
+    }
+  list_push_back (slot, &to->elem);
+}
+
+/* Adds the timeouts in SLOT again, which spreads them over the
+   levels below.  Interrupts must be off. */
+static void
+wheel_cascade (struct list *slot) 
+{
+  struct list moved;
+
+  list_init (&moved);
+  if (!list_empty (slot))
+    list_splice (list_end (&moved), list_begin (slot), list_end (slot));
+  while (!list_empty (&moved))
+    wheel_insert (list_entry (list_pop_front (&moved),
+                              struct timeout, elem));
+}
+
+/* Runs the timeouts of each tick up to NOW that has not run yet.
+   Interrupts must be off. */
+static void
+wheel_run (int64_t now) 
+{
+  while (wheel_now <= now)
+    {
+      int index = wheel_now & (WHEEL_SLOTS0 - 1);
+      struct list *slot = &wheel0[index];
+      struct list expired;
+      int level;
+
+      /* Level 0 wrapped around, refill it from the level above,
+         and that one in turn if it wrapped too. */
+      if (index == 0)
+        for (level = 0; level < WHEEL_LEVELS - 1; level++)
+          {
+            int above = (wheel_now >> (WHEEL_BITS0 + level * WHEEL_BITS))
+                        & (WHEEL_SLOTS - 1);
+            wheel_cascade (&wheel[level][above]);
+            if (above != 0)
+              break;
+          }
+
+      /* Take the slot's timeouts off the wheel before running
+         them, so that one added again lands in a later slot. */
+      list_init (&expired);
+      if (!list_empty (slot))
+        list_splice (list_end (&expired), list_begin (slot), list_end (slot));
+      wheel_now++;
+
+      while (!list_empty (&expired))
+        {
+          struct timeout *to = list_entry (list_pop_front (&expired),
+                                           struct timeout, elem);
+          if (to->deadline != 0 && to->deadline > clock_ns ())
+            {
+              /* Due later in this tick. */
+              subtick_insert (to);
+              continue;
+            }
+          to->pending = false;
+          to->func (to->aux);
+        }
+    }
+}
+
+/* Orders timeouts by deadline. */
+static bool
+deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct timeout *a = list_entry (a_, struct timeout, elem);
+  const struct timeout *b = list_entry (b_, struct timeout, elem);
+
+  return a->deadline < b->deadline;
+}
+
+/* Puts TO on subtick_list, and arms a one-shot for it unless one
+   that ends sooner is armed already.  Interrupts must be off. */
+static void
+subtick_insert (struct timeout *to) 
+{
+  uint16_t left;
+
+  list_insert_ordered (&subtick_list, &to->elem, deadline_less, NULL);
+  if (!subtick_armed)
+    {
+      /* Counter 0 is periodic, LEFT is the count to the tick. */
+      subtick_rest = 0;
+      subtick_arm (pit_read ());
+    }
+  else if (list_front (&subtick_list) == &to->elem)
+    {
+      /* Once the one-shot runs out the count wraps around above
+         what it started from; then its interrupt is pending and
+         arms for TO itself. */
+      left = pit_read ();
+      if (left <= subtick_count)
+        subtick_arm (left);
+    }
+}
+
+/* Programs counter 0 for a one-shot to the first deadline on
+   subtick_list, or to the next tick boundary if that comes first.
+   LEFT is the count still to go on the counter, which with
+   subtick_rest makes the count to the tick boundary.  Interrupts
+   must be off. */
+static void
+subtick_arm (uint16_t left) 
+{
+  int32_t boundary = left + subtick_rest;
+  int32_t count = boundary;
+
+  if (!list_empty (&subtick_list))
+    {
+      struct timeout *to = list_entry (list_front (&subtick_list),
+                                       struct timeout, elem);
+      int64_t ns = to->deadline - clock_ns ();
+
+      if (ns <= 0)
+        count = 1;
+      else if (ns < NS_PER_TICK)
+        count = DIV_ROUND_UP (ns * PIT_FREQ, 1000 * 1000 * 1000);
+      if (count > boundary)
+        count = boundary;
+    }
+
+  subtick_armed = true;
+  subtick_count = count;
+  subtick_rest = boundary - count;
+  pit_program (0x30, count);    /* Counter 0, mode 0: one-shot. */
+}
+
+/* Interrupt of a sub-tick one-shot.  Runs the timeouts that are
+   due, then arms the next one-shot, or at the tick boundary goes
+   back to periodic mode and does the tick. */
+static void
+subtick_interrupt (void) 
+{
+  if (subtick_rest == 0)
+    {
+      subtick_armed = false;
+      pit_program (0x34, PIT_TICK);
+      run_tick ();
+
+      /* Deadlines the one-shots did not reach go on in this tick. */
+      if (!subtick_armed && !list_empty (&subtick_list))
+        subtick_arm (pit_read ());
+      return;
+    }
+
+  /* Anything due within one count of the 8254 has been reached. */
+  while (!list_empty (&subtick_list))
+    {
+      struct timeout *to = list_entry (list_front (&subtick_list),
+                                       struct timeout, elem);
+      if (to->deadline > clock_ns () + 1000 * 1000 * 1000 / PIT_FREQ)
+        break;
+      list_pop_front (&subtick_list);
+      to->pending = false;
+      to->func (to->aux);
+    }
+  subtick_arm (0);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
+{
+  if (subtick_armed)
+    subtick_interrupt ();
+  else
+    run_tick ();
+}
+
+/* Does the work of one timer tick. */
+static void
+run_tick (void) 
 {
   ticks++;
   thread_tick ();
-  /*for every tick, wakeup threads whose sleep time is up*/
-  updatesleep(ticks);
+  /*for every tick, run the timeouts whose time is up*/
+  wheel_run (ticks);
   if(thread_mlfqs)
   {	
 	/*incrase recent_cpu every tick*/
@@ -213,13 +726,38 @@ real_time_sleep (int64_t num, int32_t denom)
          processes. */                
       timer_sleep (ticks); 
     }
+  else if (tsc_freq != 0)
+    {
+      /* Otherwise wait for a deadline on the TSC clock. */
+      ASSERT ((1000 * 1000 * 1000) % denom == 0);
+      sleep_until_ns (clock_ns () + num * (1000 * 1000 * 1000 / denom));
+    }
   else 
     {
-      /* Otherwise, use a busy-wait loop for more accurate
-         sub-tick timing.  We scale the numerator and denominator
-         down by 1000 to avoid the possibility of overflow. */
+      /* Before the TSC is calibrated, use a busy-wait loop for
+         more accurate sub-tick timing.  We scale the numerator and
+         denominator down by 1000 to avoid the possibility of
+         overflow. */
       ASSERT (denom % 1000 == 0);
       busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000)); 
     }
 }
 
+/* Sleeps until clock_ns() reaches DEADLINE, blocked on a timeout
+   that a one-shot of the 8254 runs between ticks. */
+static void
+sleep_until_ns (int64_t deadline) 
+{
+  struct timeout to;
+  enum intr_level old_level;
+
+  if (deadline <= clock_ns ())
+    return;
+
+  timeout_init (&to, wake_sleeper, thread_current ());
+  old_level = intr_disable ();
+  timeout_add_ns (&to, deadline);
+  thread_block ();
+  intr_set_level (old_level);
+}
+
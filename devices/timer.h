@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -13,10 +15,36 @@ void timer_calibrate (void);
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
 
+uint64_t timer_tsc (void);
+int64_t clock_ns (void);
+
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
+
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+/* A kernel timeout.  Once timer_ticks() reaches EXPIRES, FUNC is
+   called with AUX from the timer interrupt, so it must not sleep. */
+typedef void timeout_func (void *aux);
+struct timeout
+  {
+    struct list_elem elem;      /* Element in a timer wheel slot. */
+    int64_t expires;            /* Tick to run at. */
+    int64_t deadline;           /* clock_ns() to run at, or 0. */
+    timeout_func *func;         /* Function to call. */
+    void *aux;                  /* Argument for FUNC. */
+    bool pending;               /* Added and not yet run or canceled? */
+  };
+
+void timeout_init (struct timeout *, timeout_func *, void *aux);
+void timeout_add (struct timeout *, int64_t expires);
+void timeout_add_ns (struct timeout *, int64_t deadline);
+bool timeout_cancel (struct timeout *);
 #endif /* devices/timer.h */
@@ -0,0 +1,16 @@
+#ifndef __LIB_MMAN_H
+#define __LIB_MMAN_H
+
+/* Advice to madvise() about a range of user memory. */
+enum madvise_advice
+  {
+    MADV_NORMAL,                /* No particular pattern, the default. */
+    MADV_RANDOM,                /* Random access, no read-ahead, and
+                                   evict pages not used again first. */
+    MADV_SEQUENTIAL,            /* Sequential access, read far ahead
+                                   and evict the pages left behind. */
+    MADV_WILLNEED,              /* Bring the pages in now. */
+    MADV_DONTNEED               /* Drop the pages now. */
+  };
+
+#endif /* lib/mman.h */
@@ -28,7 +28,14 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_FORK,                   /* Duplicate this process. */
+    SYS_VMSTAT,                 /* Read page fault statistics. */
+    SYS_MADVISE,                /* Advise on the use of a memory range. */
+    SYS_MSYNC,                  /* Write back a memory mapping. */
+    SYS_RSSSTAT                 /* Read the resident set size. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -182,3 +182,33 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+pid_t
+fork (void)
+{
+  return (pid_t) syscall0 (SYS_FORK);
+}
+
+int
+vmstat (struct fault_stat stats[FAULT_CLASS_CNT])
+{
+  return syscall1 (SYS_VMSTAT, stats);
+}
+
+int
+madvise (void *addr, size_t length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+msync (void *addr, size_t length)
+{
+  return syscall2 (SYS_MSYNC, addr, length);
+}
+
+int
+rssstat (struct rss_stat *st)
+{
+  return syscall1 (SYS_RSSSTAT, st);
+}
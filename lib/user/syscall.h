@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <vmstat.h>
+#include <mman.h>
+#include <stddef.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +48,11 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t fork (void);
+int vmstat (struct fault_stat stats[FAULT_CLASS_CNT]);
+int madvise (void *addr, size_t length, int advice);
+int msync (void *addr, size_t length);
+int rssstat (struct rss_stat *);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,47 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Page fault classes, by the path that resolved the fault. */
+enum fault_class
+  {
+    FAULT_EXE,                  /* Page read from an executable. */
+    FAULT_MMAP,                 /* Page read from a mapped file. */
+    FAULT_SWAP,                 /* Page read back from swap. */
+    FAULT_ZERO,                 /* Shared zero page mapped on a read. */
+    FAULT_STACK,                /* Stack growth. */
+    FAULT_COW,                  /* Write to a shared or zero page. */
+    FAULT_EVICT,                /* replace_frame(), failures included. */
+    FAULT_KILL,                 /* Bad access, process killed. */
+    FAULT_LARGE,                /* 4 MB page mapped for a region. */
+    FAULT_CLASS_CNT
+  };
+
+/* Number of histogram buckets.  Bucket 0 counts latencies of 0,
+   bucket B > 0 latencies in [2**(B-1), 2**B); the last bucket
+   also takes everything above. */
+#define FAULT_TICK_BUCKETS 8
+#define FAULT_CYCLE_BUCKETS 32
+
+/* Latency statistics for one fault class. */
+struct fault_stat
+  {
+    uint64_t cnt;                               /* Number of faults. */
+    uint64_t ticks;                             /* Total timer ticks. */
+    uint64_t cycles;                            /* Total TSC cycles. */
+    uint32_t tick_hist[FAULT_TICK_BUCKETS];     /* Ticks histogram. */
+    uint32_t cycle_hist[FAULT_CYCLE_BUCKETS];   /* Cycles histogram. */
+  };
+
+/* Resident set of a process, in frames. */
+struct rss_stat
+  {
+    uint32_t rss;               /* Frames owned now. */
+    uint32_t peak;              /* Most frames owned at once. */
+    uint32_t allowance;         /* Frames allowed by the page fault
+                                   frequency controller. */
+    uint32_t max;               /* Hard cap, 0 if none. */
+  };
+
+#endif /* lib/vmstat.h */
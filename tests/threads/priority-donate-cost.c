@@ -0,0 +1,122 @@
+/* Builds chains of lock holders of growing length, up to and
+   beyond the 8 holders a donation is passed through, and reports
+   what lock_acquire() and lock_release() cost at each length.
+
+   The main thread runs at PRI_MIN and holds lock 0.  Thread i of
+   the chain, at priority PRI_MIN + i, holds lock i and waits on
+   lock i - 1.  A last thread, above the whole chain, then waits on
+   the lock of the last holder, and its donation goes down the
+   chain.  Its lock_acquire() is timed until the main thread runs
+   again, and the main thread's lock_release() of lock 0 until
+   thread 1 runs with the lock.  Each chain is built ROUND_CNT
+   times and the costs averaged. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define MAX_DEPTH 16
+#define ROUND_CNT 10
+
+static const int depths[] = {1, 2, 4, 6, 7, 8, 9, 12, MAX_DEPTH};
+
+struct link
+  {
+    struct lock *held;          /* Lock the thread holds. */
+    struct lock *wanted;        /* Lock it waits on. */
+    bool timed;                 /* Times the release of WANTED? */
+  };
+
+static thread_func chain_thread;
+static thread_func top_thread;
+
+static uint64_t acquire_start;  /* TSC as the top thread acquires. */
+static uint64_t release_start;  /* TSC as the main thread releases. */
+static uint64_t release_cycles; /* Sum over rounds, set by thread 1. */
+
+void
+test_priority_donate_cost (void)
+{
+  struct lock locks[MAX_DEPTH + 1];
+  struct link links[MAX_DEPTH + 2];
+  size_t d;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_set_priority (PRI_MIN);
+
+  for (d = 0; d < sizeof depths / sizeof *depths; d++)
+    {
+      int depth = depths[d];
+      uint64_t acquire_cycles = 0;
+      int donated = PRI_MIN;
+      int round, i;
+
+      release_cycles = 0;
+      for (round = 0; round < ROUND_CNT; round++)
+        {
+          for (i = 0; i <= depth; i++)
+            lock_init (&locks[i]);
+          lock_acquire (&locks[0]);
+
+          /* Each holder blocks on the lock below it as soon as it
+             is created, handing the CPU back. */
+          for (i = 1; i <= depth; i++)
+            {
+              char name[16];
+
+              snprintf (name, sizeof name, "holder %d", i);
+              links[i].held = &locks[i];
+              links[i].wanted = &locks[i - 1];
+              links[i].timed = i == 1;
+              thread_create (name, PRI_MIN + i, chain_thread, &links[i]);
+            }
+
+          links[depth + 1].held = NULL;
+          links[depth + 1].wanted = &locks[depth];
+          links[depth + 1].timed = false;
+          thread_create ("top", PRI_MIN + depth + 1, top_thread,
+                         &links[depth + 1]);
+          acquire_cycles += timer_tsc () - acquire_start;
+          donated = thread_get_priority ();
+
+          /* The whole chain runs down and exits before we get the
+             CPU back. */
+          release_start = timer_tsc ();
+          lock_release (&locks[0]);
+        }
+
+      msg ("Chain of %d: priority %d reaches main, "
+           "%"PRIu64" cycles to acquire, %"PRIu64" cycles to release.",
+           depth, donated, acquire_cycles / ROUND_CNT,
+           release_cycles / ROUND_CNT);
+    }
+}
+
+static void
+chain_thread (void *link_)
+{
+  struct link *link = link_;
+
+  lock_acquire (link->held);
+  lock_acquire (link->wanted);
+  if (link->timed)
+    release_cycles += timer_tsc () - release_start;
+  lock_release (link->wanted);
+  lock_release (link->held);
+}
+
+static void
+top_thread (void *link_)
+{
+  struct link *link = link_;
+
+  acquire_start = timer_tsc ();
+  lock_acquire (link->wanted);
+  lock_release (link->wanted);
+}
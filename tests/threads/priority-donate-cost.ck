@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+my (@costs) = grep (/\(priority-donate-cost\) Chain of \d+: priority \d+ reaches main, \d+ cycles to acquire, \d+ cycles to release\./,
+		    @output);
+fail "missing chain costs in output" if @costs != 9;
+print "$_\n" foreach @costs;
+
+fail "missing end in output"
+  unless grep ($_ eq '(priority-donate-cost) end', @output);
+
+pass;
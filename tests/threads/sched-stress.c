@@ -0,0 +1,67 @@
+/* Creates 500 threads spread over 16 priorities, all below the
+   main thread's, and has each yield the CPU many times before it
+   exits.  Checks that every thread finishes and reports what a
+   context switch costs with that many threads ready to run. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 500
+#define YIELD_CNT 20
+#define PRI_SPREAD 16
+
+static thread_func stress_thread;
+static struct semaphore done;
+
+void
+test_sched_stress (void) 
+{
+  uint64_t start_tsc, cycles;
+  int64_t start_ticks, ticks;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&done, 0);
+  msg ("Creating %d threads at %d priorities.", THREAD_CNT, PRI_SPREAD);
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "stress %d", i);
+      if (thread_create (name, PRI_DEFAULT - 1 - i % PRI_SPREAD,
+                         stress_thread, NULL) == TID_ERROR)
+        fail ("thread_create failed for thread %d", i);
+    }
+
+  msg ("Waiting for all threads to yield %d times and exit.", YIELD_CNT);
+  start_ticks = timer_ticks ();
+  start_tsc = timer_tsc ();
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  cycles = timer_tsc () - start_tsc;
+  ticks = timer_elapsed (start_ticks);
+
+  msg ("All threads finished.");
+  msg ("%d yields in %"PRId64" ticks, %"PRIu64" cycles per switch.",
+       THREAD_CNT * YIELD_CNT, ticks,
+       cycles / (THREAD_CNT * (YIELD_CNT + 2)));
+}
+
+static void 
+stress_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    thread_yield ();
+  sema_up (&done);
+}
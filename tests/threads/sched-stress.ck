@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing \"All threads finished\" in output"
+  unless grep ($_ eq '(sched-stress) All threads finished.', @output);
+
+my ($cost) = grep (/\(sched-stress\) \d+ yields in \d+ ticks, \d+ cycles per switch\./,
+		   @output);
+fail "missing context switch cost in output" if !defined $cost;
+print "$cost\n";
+
+fail "missing end in output"
+  unless grep ($_ eq '(sched-stress) end', @output);
+
+pass;
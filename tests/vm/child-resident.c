@@ -0,0 +1,27 @@
+/* Child process of exec-latency.
+   Touches every page of 1 MB, the resident set fork-latency
+   starts from, and checks it. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-resident";
+
+#define SIZE (1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char buf[SIZE];
+
+int
+main (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    buf[i] = i / PAGE_SIZE;
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    if (buf[i] != (char) (i / PAGE_SIZE))
+      fail ("page %zu has the wrong contents", i / PAGE_SIZE);
+
+  return 0x42;
+}
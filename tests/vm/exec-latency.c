@@ -0,0 +1,25 @@
+/* Execs a process with a 1 MB resident set several times, one
+   at a time.  The timer statistics of the run give the cost of
+   exec, to compare with fork-latency. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 16
+
+void
+test_main (void)
+{
+  int child;
+
+  msg ("exec %d children", CHILD_CNT);
+  for (child = 0; child < CHILD_CNT; child++)
+    {
+      pid_t pid = exec ("child-resident");
+      if (pid == -1)
+        fail ("exec child %d", child);
+      if (wait (pid) != 0x42)
+        fail ("wait for child %d", child);
+    }
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(exec-latency) begin
+(exec-latency) exec 16 children
+(exec-latency) end
+EOF
+
+# Report the cost of the run, to compare with fork-latency.
+my (@output) = read_text_file ("$test.output");
+my ($ticks) = map (/Timer: (\d+) ticks/, @output);
+my ($faults) = map (/Exception: (\d+) page faults/, @output);
+print "16 execs: $faults page faults in $ticks ticks\n"
+  if defined $ticks && defined $faults;
+pass;
@@ -0,0 +1,50 @@
+/* Forks a process with a 1 MB resident set several times.  Each
+   child checks that it sees the parent's memory, writes to one
+   page of it and exits; the parent then checks that the write did
+   not reach its own copy.  The timer statistics of the run give the
+   cost of fork, to compare with exec-latency. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (1024 * 1024)
+#define PAGE_SIZE 4096
+#define CHILD_CNT 16
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  int child;
+
+  msg ("touch every page");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    buf[i] = i / PAGE_SIZE;
+
+  msg ("fork %d children", CHILD_CNT);
+  for (child = 0; child < CHILD_CNT; child++)
+    {
+      pid_t pid = fork ();
+      if (pid == 0)
+        {
+          for (i = 0; i < SIZE; i += PAGE_SIZE)
+            if (buf[i] != (char) (i / PAGE_SIZE))
+              fail ("child %d: page %zu has the wrong contents", child,
+                    i / PAGE_SIZE);
+          buf[child * PAGE_SIZE] = -1;
+          exit (0x42);
+        }
+      if (pid == -1)
+        fail ("fork child %d", child);
+      if (wait (pid) != 0x42)
+        fail ("wait for child %d", child);
+    }
+
+  msg ("verify every page");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    if (buf[i] != (char) (i / PAGE_SIZE))
+      fail ("page %zu was changed by a child", i / PAGE_SIZE);
+}
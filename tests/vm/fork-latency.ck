@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fork-latency) begin
+(fork-latency) touch every page
+(fork-latency) fork 16 children
+(fork-latency) verify every page
+(fork-latency) end
+EOF
+
+# Report the cost of the run, to compare with exec-latency.
+my (@output) = read_text_file ("$test.output");
+my ($ticks) = map (/Timer: (\d+) ticks/, @output);
+my ($faults) = map (/Exception: (\d+) page faults/, @output);
+print "16 forks: $faults page faults in $ticks ticks\n"
+  if defined $ticks && defined $faults;
+pass;
@@ -0,0 +1,53 @@
+/* Maps a 4 MB file and touches every page of the mapping, so
+   that the cost of servicing page faults on a large mapping
+   shows up in the kernel's page fault and timer statistics. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (4 * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_SIZE];
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  mapid_t map;
+  size_t ofs;
+
+  CHECK (create ("large.dat", SIZE), "create \"large.dat\"");
+  CHECK ((handle = open ("large.dat")) > 1, "open \"large.dat\"");
+
+  /* Give every page its own fill byte. */
+  msg ("write \"large.dat\"");
+  for (ofs = 0; ofs < SIZE; ofs += PAGE_SIZE)
+    {
+      memset (buf, ofs / PAGE_SIZE, PAGE_SIZE);
+      if (write (handle, buf, PAGE_SIZE) != PAGE_SIZE)
+        fail ("write of page at offset %zu failed", ofs);
+    }
+
+  CHECK ((map = mmap (handle, actual)) != MAP_FAILED, "mmap \"large.dat\"");
+
+  /* Fault in every page of the mapping once. */
+  msg ("touch every page");
+  for (ofs = 0; ofs < SIZE; ofs += PAGE_SIZE)
+    if (actual[ofs] != (char) (ofs / PAGE_SIZE))
+      fail ("byte %zu of mmap'd region has value %02hhx (should be %02hhx)",
+            ofs, actual[ofs], (char) (ofs / PAGE_SIZE));
+
+  /* Check the last byte of every page as well. */
+  msg ("verify every page");
+  for (ofs = PAGE_SIZE - 1; ofs < SIZE; ofs += PAGE_SIZE)
+    if (actual[ofs] != (char) (ofs / PAGE_SIZE))
+      fail ("byte %zu of mmap'd region has value %02hhx (should be %02hhx)",
+            ofs, actual[ofs], (char) (ofs / PAGE_SIZE));
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-large) begin
+(mmap-large) create "large.dat"
+(mmap-large) open "large.dat"
+(mmap-large) write "large.dat"
+(mmap-large) mmap "large.dat"
+(mmap-large) touch every page
+(mmap-large) verify every page
+(mmap-large) end
+EOF
+
+# Report the fault cost of the run.
+my (@output) = read_text_file ("$test.output");
+my ($ticks) = map (/Timer: (\d+) ticks/, @output);
+my ($faults) = map (/Exception: (\d+) page faults/, @output);
+print "$faults page faults in $ticks ticks\n"
+  if defined $ticks && defined $faults;
+pass;
@@ -0,0 +1,68 @@
+/* Writes to a file through a mapping and flushes it with msync(),
+   then reads the file back with the read system call while the
+   mapping is still in place.  Writes after the flush reach the file
+   on munmap(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Reads the whole file "data" into BUF through a handle of its own. */
+static void
+read_back (void)
+{
+  int handle;
+
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK (read (handle, buf, sizeof buf) == (int) sizeof buf, "read \"data\"");
+  close (handle);
+}
+
+/* Byte I of "data" once the second page was written again. */
+static char
+final_byte (size_t i)
+{
+  if (i >= PAGE_SIZE && i < 2 * PAGE_SIZE)
+    return 'b';
+  return i < 3 * PAGE_SIZE ? 'a' : 0;
+}
+
+void
+test_main (void)
+{
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  CHECK (create ("data", sizeof buf), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"data\"");
+
+  /* Dirty the first three pages; the last one is only read. */
+  memset (ACTUAL, 'a', 3 * PAGE_SIZE);
+  if (ACTUAL[3 * PAGE_SIZE] != 0)
+    fail ("last page is not zero");
+  CHECK (msync (ACTUAL, sizeof buf) == 0, "msync");
+  read_back ();
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != (i < 3 * PAGE_SIZE ? 'a' : 0))
+      fail ("byte %zu of \"data\" is %02hhx after msync", i, buf[i]);
+
+  /* The mapping is still in place. */
+  memset (ACTUAL + PAGE_SIZE, 'b', PAGE_SIZE);
+  CHECK (msync (ACTUAL + 1, PAGE_SIZE) == -1, "msync unaligned");
+  munmap (map);
+  close (handle);
+
+  read_back ();
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != final_byte (i))
+      fail ("byte %zu of \"data\" is %02hhx after munmap", i, buf[i]);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-msync) begin
+(mmap-msync) create "data"
+(mmap-msync) open "data"
+(mmap-msync) mmap "data"
+(mmap-msync) msync
+(mmap-msync) open "data"
+(mmap-msync) read "data"
+(mmap-msync) msync unaligned
+(mmap-msync) open "data"
+(mmap-msync) read "data"
+(mmap-msync) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* Writes and then reads back every page of a 4 MB array aligned to
+   4 MB, which the kernel run with -vm-large maps with one large
+   page, and then of a 4 MB array on the stack, which always takes
+   4 kB pages.  Checks with vmstat that the large page took fewer
+   page faults.  The fault statistics of the run give the cost of
+   each scan. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LARGE_SIZE (4 * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char big[LARGE_SIZE] __attribute__ ((aligned (LARGE_SIZE)));
+
+/* Returns the number of page faults taken so far. */
+static uint64_t
+fault_cnt (void)
+{
+  struct fault_stat stats[FAULT_CLASS_CNT];
+  uint64_t cnt = 0;
+  int cls;
+
+  CHECK (vmstat (stats) == FAULT_CLASS_CNT, "vmstat");
+  for (cls = 0; cls < FAULT_CLASS_CNT; cls++)
+    if (cls != FAULT_EVICT)
+      cnt += stats[cls].cnt;
+  return cnt;
+}
+
+/* Scans the 4 MB at BUF sequentially and returns the number of
+   page faults it took. */
+static uint64_t
+scan (char *buf)
+{
+  uint64_t start = fault_cnt ();
+  size_t i;
+
+  for (i = 0; i < LARGE_SIZE; i += PAGE_SIZE)
+    buf[i] = i / PAGE_SIZE;
+  for (i = 0; i < LARGE_SIZE; i += PAGE_SIZE)
+    if (buf[i] != (char) (i / PAGE_SIZE))
+      fail ("page %zu has the wrong contents", i / PAGE_SIZE);
+  return fault_cnt () - start;
+}
+
+void
+test_main (void)
+{
+  char small[LARGE_SIZE];
+  uint64_t large_faults, small_faults;
+
+  msg ("scan with large pages");
+  large_faults = scan (big);
+  msg ("scan with 4 kB pages");
+  small_faults = scan (small);
+  if (large_faults >= small_faults)
+    fail ("large pages took %d faults, 4 kB pages %d",
+          (int) large_faults, (int) small_faults);
+}
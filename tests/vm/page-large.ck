@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-large) begin
+(page-large) scan with large pages
+(page-large) vmstat
+(page-large) vmstat
+(page-large) scan with 4 kB pages
+(page-large) vmstat
+(page-large) vmstat
+(page-large) end
+EOF
+
+# Report the cost of both scans.
+my (@output) = read_text_file ("$test.output");
+foreach my $class ('large', 'stack') {
+  my ($faults, $cycles)
+    = map (/Fault: $class (\d+) faults, \d+ ticks, (\d+) cycles/, @output);
+  print "$class: $faults faults in $cycles cycles\n" if defined $cycles;
+}
+pass;
@@ -0,0 +1,65 @@
+/* Gives madvise() advice on a memory mapped file and on an array the
+   program writes, checking each against the page fault statistics:
+   after MADV_WILLNEED the mapped page is read with no fault, after
+   MADV_DONTNEED it faults again and still holds the file's data, and
+   the written array reads back as zero.  Bad arguments are refused. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+static struct fault_stat before[FAULT_CLASS_CNT], after[FAULT_CLASS_CNT];
+
+/* Number of faults on mapped files since BEFORE was taken. */
+static int
+mmap_faults (void)
+{
+  CHECK (vmstat (after) == FAULT_CLASS_CNT, "vmstat");
+  return after[FAULT_MMAP].cnt - before[FAULT_MMAP].cnt;
+}
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (handle, actual)) != MAP_FAILED, "mmap \"sample.txt\"");
+
+  CHECK (madvise (actual, PAGE_SIZE, MADV_WILLNEED) == 0, "madvise willneed");
+  vmstat (before);
+  if (memcmp (actual, sample, strlen (sample)))
+    fail ("read of prefetched page reported bad data");
+  if (mmap_faults () != 0)
+    fail ("prefetched page faulted");
+
+  CHECK (madvise (actual, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise dontneed");
+  vmstat (before);
+  if (memcmp (actual, sample, strlen (sample)))
+    fail ("read of dropped page reported bad data");
+  if (mmap_faults () != 1)
+    fail ("dropped page did not fault once");
+  munmap (map);
+  close (handle);
+
+  msg ("write every page");
+  for (i = 0; i < sizeof buf; i += PAGE_SIZE)
+    buf[i] = 1;
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0, "madvise dontneed");
+  for (i = 0; i < sizeof buf; i += PAGE_SIZE)
+    if (buf[i] != 0)
+      fail ("dropped page %zu is not zero", i / PAGE_SIZE);
+
+  CHECK (madvise (buf + 1, PAGE_SIZE, MADV_DONTNEED) == -1,
+         "madvise unaligned");
+  CHECK (madvise (actual, PAGE_SIZE, 99) == -1, "madvise bad advice");
+}
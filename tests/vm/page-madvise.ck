@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-madvise) begin
+(page-madvise) open "sample.txt"
+(page-madvise) mmap "sample.txt"
+(page-madvise) madvise willneed
+(page-madvise) vmstat
+(page-madvise) madvise dontneed
+(page-madvise) vmstat
+(page-madvise) write every page
+(page-madvise) madvise dontneed
+(page-madvise) madvise unaligned
+(page-madvise) madvise bad advice
+(page-madvise) end
+EOF
+pass;
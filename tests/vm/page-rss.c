@@ -0,0 +1,38 @@
+/* Writes an array four times the hard cap on resident frames, which
+   the kernel is started with, and checks that the process never owned
+   more frames than the cap while the array still reads back intact
+   from swap. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define RSS_MAX 64
+#define PAGE_CNT (4 * RSS_MAX)
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct rss_stat st;
+  size_t i;
+
+  msg ("write every page");
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = i;
+
+  msg ("read every page");
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("page %zu has value %d", i, buf[i * PAGE_SIZE]);
+
+  CHECK (rssstat (&st) == 0, "rssstat");
+  if (st.max != RSS_MAX)
+    fail ("hard cap is %u frames", (unsigned) st.max);
+  if (st.peak > RSS_MAX)
+    fail ("owned %u frames at once", (unsigned) st.peak);
+  if (st.rss > st.peak || st.allowance > RSS_MAX)
+    fail ("%u frames, %u allowed", (unsigned) st.rss, (unsigned) st.allowance);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-rss) begin
+(page-rss) write every page
+(page-rss) read every page
+(page-rss) rssstat
+(page-rss) end
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Reads and then writes pages of an array the program never
+   initialized, and checks that the page fault statistics returned by
+   the vmstat system call account for them: each read maps the zero
+   page, each later write copies it, and every class's histograms add
+   up to its fault count. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+static struct fault_stat before[FAULT_CLASS_CNT], after[FAULT_CLASS_CNT];
+
+static void
+check_hist (const struct fault_stat *st, int cls)
+{
+  uint64_t ticks = 0, cycles = 0;
+  int b;
+
+  for (b = 0; b < FAULT_TICK_BUCKETS; b++)
+    ticks += st->tick_hist[b];
+  for (b = 0; b < FAULT_CYCLE_BUCKETS; b++)
+    cycles += st->cycle_hist[b];
+  if (ticks != st->cnt || cycles != st->cnt)
+    fail ("histograms of class %d do not add up", cls);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+  int cls;
+
+  CHECK (vmstat (before) == FAULT_CLASS_CNT, "vmstat");
+
+  msg ("read every page");
+  for (i = 0; i < sizeof buf; i += PAGE_SIZE)
+    if (buf[i] != 0)
+      fail ("page %zu is not zero", i / PAGE_SIZE);
+
+  msg ("write every page");
+  for (i = 0; i < sizeof buf; i += PAGE_SIZE)
+    buf[i] = 1;
+
+  CHECK (vmstat (after) == FAULT_CLASS_CNT, "vmstat");
+  if (after[FAULT_ZERO].cnt - before[FAULT_ZERO].cnt < PAGE_CNT)
+    fail ("only %d zero page faults",
+          (int) (after[FAULT_ZERO].cnt - before[FAULT_ZERO].cnt));
+  if (after[FAULT_COW].cnt - before[FAULT_COW].cnt < PAGE_CNT)
+    fail ("only %d copy-on-write faults",
+          (int) (after[FAULT_COW].cnt - before[FAULT_COW].cnt));
+  for (cls = 0; cls < FAULT_CLASS_CNT; cls++)
+    check_hist (&after[cls], cls);
+}
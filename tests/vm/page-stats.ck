@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-stats) begin
+(page-stats) vmstat
+(page-stats) read every page
+(page-stats) write every page
+(page-stats) vmstat
+(page-stats) end
+EOF
+pass;
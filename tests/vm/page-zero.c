@@ -0,0 +1,37 @@
+/* Reads every page of a 2 MB array that the program never
+   initialized, then writes to a few of its pages, and checks that
+   only those pages changed.  Untouched pages are expected to be
+   backed by the shared zero page until written. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 1024 * 1024)
+#define PAGE_SIZE 4096
+#define STRIDE (8 * PAGE_SIZE)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  msg ("read every page");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    if (buf[i] != 0)
+      fail ("page %zu is not zero", i / PAGE_SIZE);
+
+  msg ("write every 8th page");
+  for (i = 0; i < SIZE; i += STRIDE)
+    memset (buf + i, 0x5a, PAGE_SIZE);
+
+  msg ("verify every page");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    {
+      char expected = i % STRIDE == 0 ? 0x5a : 0;
+      if (buf[i] != expected || buf[i + PAGE_SIZE - 1] != expected)
+        fail ("page %zu has the wrong contents", i / PAGE_SIZE);
+    }
+}
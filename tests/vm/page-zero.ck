@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-zero) begin
+(page-zero) read every page
+(page-zero) write every 8th page
+(page-zero) verify every page
+(page-zero) end
+EOF
+pass;
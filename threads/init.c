@@ -37,6 +37,8 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/fault.h"
+#include "vm/zswap.h"
 
 /* Amount of physical memory, in 4 kB pages. */
 size_t ram_pages;
@@ -44,6 +46,9 @@ size_t ram_pages;
 /* Page directory with kernel mappings only. */
 uint32_t *base_page_dir;
 
+/* CPU supports 4 MB pages, enabled in CR4. */
+bool paging_pse;
+
 #ifdef FILESYS
 /* -f: Format the file system? */
 static bool format_filesys;
@@ -123,6 +128,9 @@ main (void)
 #ifdef USERPROG
   swap_init();
 #endif
+#ifdef VM
+  frame_cleaner_start ();
+#endif
 
   printf ("Boot complete.\n");
   
@@ -166,6 +174,7 @@ paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
+  uint32_t eax, ebx, ecx, edx, cr4;
   extern char _start, _end_kernel_text;
 
   pd = base_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
@@ -193,6 +202,19 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (base_page_dir)));
+
+  /* Allow 4 MB pages in page directory entries if the CPU has
+     PSE, reported in bit 3 of EDX by CPUID function 1, by setting
+     bit 4 of CR4.  See [IA32-v3a] 3.7.3 "Mixing 4-KByte and
+     4-MByte Pages". */
+  eax = 1;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  if (edx & (1 << 3))
+    {
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | (1 << 4)));
+      paging_pse = true;
+    }
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -253,9 +275,28 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-vm-low"))
+        frame_low_watermark = atoi (value);
+      else if (!strcmp (name, "-vm-high"))
+        frame_high_watermark = atoi (value);
+      else if (!strcmp (name, "-vm-rss"))
+        frame_rss_max = atoi (value);
+      else if (!strcmp (name, "-vm-zswap"))
+        zswap_pool_pages = atoi (value);
+      else if (!strcmp (name, "-vm-large"))
+        frame_large_pages = true;
+      else if (!strcmp (name, "-vm-policy"))
+        {
+          if (!frame_set_policy (value))
+            PANIC ("unknown replacement policy `%s' (use -h for help)", value);
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -359,8 +400,17 @@ usage (void)
           "  -f                 Format file system disk during startup.\n"
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -tickless          Stop the timer tick while idle.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -vm-low=COUNT      Wake page cleaner below COUNT free frames.\n"
+          "  -vm-high=COUNT     Page cleaner frees up to COUNT frames.\n"
+          "  -vm-policy=NAME    Page replacement: clock, wsclock or 2q.\n"
+          "  -vm-rss=COUNT      Limit each process to COUNT resident frames.\n"
+          "  -vm-zswap=PAGES    Keep up to PAGES of compressed swap in RAM.\n"
+          "  -vm-large          Map large aligned regions with 4 MB pages.\n"
 #endif
           );
   power_off ();
@@ -405,4 +455,10 @@ print_stats (void)
 #ifdef USERPROG
   exception_print_stats ();
 #endif
+#ifdef VM
+  frame_print_stats ();
+  fault_print_stats ();
+  page_print_stats ();
+  swap_print_stats ();
+#endif
 }
@@ -12,6 +12,9 @@ extern size_t ram_pages;
 /* Page directory with kernel mappings only. */
 extern uint32_t *base_page_dir;
 
+/* CPU supports 4 MB pages, enabled in CR4. */
+extern bool paging_pse;
+
 /* -q: Power off when kernel tasks complete? */
 extern bool power_off_when_done;
 
@@ -353,6 +353,9 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = true;
       yield_on_return = false;
+
+      /* Catch up on ticks skipped while idle. */
+      timer_idle_exit ();
     }
 
   /* Invoke the interrupt's handler. */
@@ -110,6 +110,47 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   return pages;
 }
 
+/* Obtains a group of PAGE_CNT contiguous free pages whose kernel
+   virtual address is a multiple of ALIGN_CNT pages, as for
+   palloc_get_multiple().  Used for large pages, which must be
+   physically aligned to their size. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt, size_t align_cnt)
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  size_t pool_cnt = bitmap_size (pool->used_map);
+  size_t page_idx;
+  void *pages = NULL;
+
+  ASSERT (align_cnt > 0);
+  if (page_cnt == 0)
+    return NULL;
+
+  /* Only indexes landing on an aligned address are candidates. */
+  page_idx = (align_cnt - pg_no (pool->base) % align_cnt) % align_cnt;
+  lock_acquire (&pool->lock);
+  for (; page_idx + page_cnt <= pool_cnt; page_idx += align_cnt)
+    if (bitmap_none (pool->used_map, page_idx, page_cnt))
+      {
+        bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+        pages = pool->base + PGSIZE * page_idx;
+        break;
+      }
+  lock_release (&pool->lock);
+
+  if (pages != NULL) 
+    {
+      if (flags & PAL_ZERO)
+        memset (pages, 0, PGSIZE * page_cnt);
+    }
+  else 
+    {
+      if (flags & PAL_ASSERT)
+        PANIC ("palloc_get: out of pages");
+    }
+  return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -158,6 +199,21 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Returns the kernel virtual address of the first page in the
+   user pool. */
+void *
+palloc_user_base (void)
+{
+  return user_pool.base;
+}
+
+/* Returns the number of pages in the user pool. */
+size_t
+palloc_user_page_cnt (void)
+{
+  return bitmap_size (user_pool.used_map);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
@@ -17,7 +17,11 @@ extern size_t user_page_limit;
 void palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned (enum palloc_flags, size_t page_cnt,
+                          size_t align_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void *palloc_user_base (void);
+size_t palloc_user_page_cnt (void);
 
 #endif /* threads/palloc.h */
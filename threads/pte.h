@@ -66,6 +66,11 @@ static inline uintptr_t pd_no (const void *va) {
 #define PTE_U 0x4               /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20              /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40              /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_SHARED 0x200        /* 1=page not freed with the page
+                                   directory (PTEs only, in PTE_AVL). */
+#define PTE_PS 0x80             /* 1=PDE maps a 4 MB page, 0=PDE points
+                                   to a page table (PDEs only, needs
+                                   CR4.PSE). */
 
 /* Returns a PDE that points to page table PT. */
 static inline uint32_t pde_create (uint32_t *pt) {
@@ -97,6 +102,14 @@ static inline uint32_t pte_create_user (void *page, bool writable) {
   return pte_create_kernel (page, writable) | PTE_U;
 }
 
+/* Returns a PDE that maps the PTSPAN bytes at PAGE, which must be
+   aligned to PTSPAN, as one large page usable by user and kernel
+   code.  If WRITABLE is true the page is writable as well. */
+static inline uint32_t pde_create_large (void *page, bool writable) {
+  ASSERT (vtop (page) % PTSPAN == 0);
+  return vtop (page) | PTE_PS | PTE_U | PTE_P | (writable ? PTE_W : 0);
+}
+
 /* Returns a pointer to the page that page table entry PTE points
    to. */
 static inline void *pte_get_page (uint32_t pte) {
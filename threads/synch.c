@@ -222,20 +222,26 @@ lock_acquire (struct lock *lock)
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  /* Set before donating, so that lock_release finds the donation. */
+  thread_current ()->wait_lock = lock;
+
   /* Keep elem2 of the thread which tries to acquire the lock */
+  enum intr_level old_level;
+  old_level = intr_disable ();
   if(lock->holder != NULL){
 	  /* When the running thread's priority is higher than holder's priority, */
 	  if(thread_get_priority() > get_priority(lock->holder)){
-		enum intr_level old_level;
-		
-		old_level = intr_disable ();
 		/* then keep elem2 of the trier in donate_list of holder.  */
 		list_push_back(&lock->holder->donate_list, &thread_current()->elem2);
-		intr_set_level (old_level);
+
+		/* and raise the holder and those it waits on in turn. */
+		thread_donate(lock->holder);
 	  }
   }
+  intr_set_level (old_level);
 
   sema_down (&lock->semaphore);
+  thread_current ()->wait_lock = NULL;
   lock->holder = thread_current ();
 }
 
@@ -272,18 +278,21 @@ lock_release (struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
 
   if(!list_empty(&lock->holder->donate_list)){
-	/* If waiters exist in the list, */
-	if(!list_empty(&lock->semaphore.waiters)){
-		struct list_elem *find;
+	enum intr_level old_level;
 
-		/* then remove all of them from the donate_list of holder. */
-		for(find = list_begin(&lock->semaphore.waiters);
-			find != list_end(&lock->semaphore.waiters);
-			find = list_next(find))
-		{
-			list_remove(&list_entry(find, struct thread, elem)->elem2);
-		}
+	old_level = intr_disable ();
+	/* Take back the donations of the threads waiting on this lock, */
+	struct list_elem *find = list_begin(&lock->holder->donate_list);
+	while(find != list_end(&lock->holder->donate_list))
+	{
+		struct thread *donor = list_entry(find, struct thread, elem2);
+		find = list_next(find);
+		if(donor->wait_lock == lock)
+			list_remove(&donor->elem2);
 	}
+	/* and drop back to the highest priority still donated. */
+	thread_update_priority(lock->holder);
+	intr_set_level (old_level);
   }
 
   lock->holder = NULL;
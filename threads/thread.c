@@ -12,6 +12,7 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include <string.h>
@@ -26,11 +27,13 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-//static struct list ready_list;
-/* List of processes which is sleeping*/
-static struct list sleep_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  One FIFO list per
+   priority and a bitmap of the nonempty ones, so that a thread is
+   queued and the next one picked in constant time. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_bitmap;   /* Bit P set if ready_queues[P] is nonempty. */
+static size_t ready_cnt;        /* Number of threads in ready_queues. */
 /* List of processes which is blocked*/
 static struct list block_list;
 /* load = load_avg it shows the average load in ready queue*/
@@ -61,6 +64,9 @@ static long long user_ticks;    /* # of timer ticks in user programs. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
+/* Priority donation. */
+#define DONATE_DEPTH 8          /* Max holders a donation passes through. */
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
@@ -77,8 +83,13 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static int ready_priority (struct thread *);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static int ready_top (void);
+static struct thread *ready_pop (void);
+static void thread_requeue (struct thread *);
 void priority_update(void);
-static int i;
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
    general and it is possible in this case only because loader.S
@@ -95,11 +106,13 @@ static int i;
 void
 thread_init (void) 
 {
+  int pri;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&sleep_list);
-  list_init (&ready_list);
+  for (pri = PRI_MIN; pri <= PRI_MAX; pri++)
+    list_init (&ready_queues[pri]);
   list_init (&block_list);
 
   if(thread_mlfqs)
@@ -294,11 +307,8 @@ thread_unblock (struct thread *t)
 		t->priority=PRI_MAX;
   	if(t->priority<PRI_MIN)
 		t->priority=PRI_MIN;
-				
-  	push2mlfq(t);
   }
-  else
-	  list_push_back (&ready_list, &t->elem);
+  ready_push (t);
   
   t->status = THREAD_READY;
   intr_set_level (old_level);
@@ -371,13 +381,7 @@ thread_yield (void)
 
   /* insert thread in ready list which is not idle*/
   if (curr != idle_thread)
-  {
-  	if(thread_mlfqs)
-		push2mlfq(curr);
-  
-  	else
-		list_push_back (&ready_list, &curr->elem);
-  }
+    ready_push (curr);
 
   curr->status = THREAD_READY;
   schedule ();
@@ -389,81 +393,77 @@ thread_set_priority (int new_priority)
 {
 	if(!thread_mlfqs)
 	{
+		enum intr_level old_level;
+		bool yield;
+		old_level = intr_disable ();
 		thread_current ()->priority = new_priority;
+		thread_update_priority (thread_current ());
 
 		/* When the changed priority of the running thread, the higher priority thread in ready list */ 
 		/* should be running if the priority of the running thread is lower than the priority of one */ 
 		/* of threads in ready list. */
-		enum intr_level old_level;
-		old_level = intr_disable ();
+		yield = ready_cnt > 0 && ready_top () > thread_get_priority ();
+		intr_set_level (old_level);
 
-		if(!list_empty(&ready_list))
-		{
-			struct list_elem *find;
-			struct thread * higher_priority_thread;
-			int max=new_priority;
-			int compare;
-
-			/* Looking for the highest priority thread in the ready list */
-			for(find = list_begin(&ready_list);
-				find != list_end(&ready_list); 
-				find = list_next(find))
-			{	
-				ASSERT(find!=NULL);
-				struct thread * temp = list_entry(find, struct thread, elem);
-
-				ASSERT(temp!=NULL);
-				compare=get_priority(temp);
-
-				if(compare > max){
-					max = compare;
-					higher_priority_thread=temp;
-				}
-			}
-
-			intr_set_level (old_level);
-
-			/* If the highest priority thread in the ready list has higher priority than the running */
-			/* thread, the running thread should yield CPU to the thread immediately. */
-			if(max > new_priority)
-				thread_yield();
-		}
+		if(yield)
+			thread_yield();
 	}
 }
 
-/* A function for tracking the highest priority recursively among the waiters in donate_list */
+/* Returns the priority of TARGET with donations, which is kept in
+   eff_priority as donations come and go. */
 int 
 get_priority(struct thread *target){
   
   if(!thread_mlfqs)
-  {
-	int max = target->priority;
-
-	/* If donate_list is empty, */
-	if(list_size(&target->donate_list)==0){
-		/* then it returns its own priority. */
-		return max;
-	}else{
-		/* If not, it tracks all elem2 from the donate_list recursively. */
-		struct list_elem *find;
-		for(find = list_begin(&target->donate_list);
-			find != list_end(&target->donate_list);
-			find = list_next(find))
-		{
-			struct thread *temp = list_entry(find ,struct thread, elem2);
-			int tt = get_priority(temp);
-			/* If the corresponding thread has higher priority */
-			if( max < tt ){
-				/* then it changes the max value with the priority.*/
-				max = tt;
-			}
-		}
-
-		/* It returns the maximum value. */
-		return max;
+	return target->eff_priority;
+  return -1;
+}
+
+/* Recomputes the priority of T with donations from its own and the
+   cached ones of the threads in its donate_list, and moves T to its
+   new ready queue.  Returns true if it changed.  Interrupts must be
+   off. */
+bool
+thread_update_priority (struct thread *t)
+{
+	struct list_elem *find;
+	int max = t->priority;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for(find = list_begin(&t->donate_list);
+		find != list_end(&t->donate_list);
+		find = list_next(find))
+	{
+		struct thread *temp = list_entry(find ,struct thread, elem2);
+		if( max < temp->eff_priority )
+			max = temp->eff_priority;
+	}
+
+	if(max == t->eff_priority)
+		return false;
+	t->eff_priority = max;
+	thread_requeue (t);
+	return true;
+}
+
+/* Passes a donation to T up the chain of lock holders it waits
+   on, stopping where a priority does not change or after
+   DONATE_DEPTH holders.  Interrupts must be off. */
+void
+thread_donate (struct thread *t)
+{
+	int depth;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for(depth = 0; t != NULL && depth < DONATE_DEPTH; depth++)
+	{
+		if(!thread_update_priority (t))
+			break;
+		t = t->wait_lock != NULL ? t->wait_lock->holder : NULL;
 	}
-  }
-	return -1;
 }
 
 /* Returns the current thread's priority. */
@@ -533,6 +533,10 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nothing else can run, so skip the ticks until the next
+         timeout, if tickless idle is on. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -597,14 +601,17 @@ init_thread (struct thread *t, const char *name, int priority)
 
   /*advanced scheduler does not use set, get priority*/
   if(!thread_mlfqs) 
-	  t->priority = priority;
+	  t->priority = t->eff_priority = priority;
 
   list_init(&t->donate_list); /* Initialize donate_list  */
   list_init(&t->child_list);
   list_init(&t->terminated_child_list);
-  /*project 3 : initialize the supplement */
-  list_init(&t->sp_table);
+  /*project 3 : initialize the supplement lock,
+    the supplement table is initialized when the process is loaded */
   lock_init(&t->sp_lock);
+  list_init(&t->vma_list);
+  list_init(&t->frame_list);
+  list_init(&t->shared_list);
 
   /* This semaphore will be used for system call wait(). */
   sema_init(&t->exit_sema, 0);
@@ -632,58 +639,91 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if(thread_mlfqs)
-  {
-	struct thread * result;
-	struct list_elem * elem = pop_from_mlfq();
+  if (ready_cnt == 0)
+    return idle_thread;
+  return ready_pop ();
+}
 
-	/*if ready_list empty */
-	if(elem==NULL)
-	{
-		result=NULL;
-		/*return idle_thread*/
-		return idle_thread;
-	}
-	else
-		result = list_entry(elem, struct thread, elem);
+/* Priority T is queued at: its own under the advanced scheduler,
+   otherwise the one it has with donations. */
+static int
+ready_priority (struct thread *t)
+{
+  return thread_mlfqs ? t->priority : get_priority (t);
+}
 
-	if(result!=NULL)
-		return result;
-  }
-  else
-  {
-	  if (list_empty (&ready_list))
-	    return idle_thread;
-	  else{
-	    struct list_elem *find;
-	    struct thread * higher_priority_thread = list_entry(list_begin(&ready_list), struct thread, elem);
-	    int max = -1;
-
-	    /* 1. Looking for the highest priority thread */
-	    for(find = list_begin(&ready_list);
-		find != list_end(&ready_list);
-		find = list_next(find))
-	    {
-			struct thread * temp = list_entry(find, struct thread, elem);
-			int tt = get_priority(temp);
-			if(tt > max){
-				max = tt;
-				higher_priority_thread = temp;
-			}
-	    }  
-
-	    /* 2. Pop the thread from the ready list */
-	    enum intr_level old_level;
-	    old_level = intr_disable ();
-	    list_remove(&higher_priority_thread->elem);
-	    intr_set_level (old_level);
-
-	    /* 3. Return the thread */
-	    return higher_priority_thread;  
-	  }
-  }
+/* Adds T to the back of the ready queue of its priority.
+   Interrupts must be off. */
+static void
+ready_push (struct thread *t)
+{
+  int pri = ready_priority (t);
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= pri && pri <= PRI_MAX);
 
-  return NULL;
+  t->queue_pri = pri;
+  list_push_back (&ready_queues[pri], &t->elem);
+  ready_bitmap |= (uint64_t) 1 << pri;
+  ready_cnt++;
+}
+
+/* Removes T from the ready queue it is on.  Interrupts must be
+   off. */
+static void
+ready_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[t->queue_pri]))
+    ready_bitmap &= ~((uint64_t) 1 << t->queue_pri);
+  ready_cnt--;
+}
+
+/* Returns the highest priority with a thread ready to run, by bsr on
+   the bitmap.  There must be one. */
+static int
+ready_top (void)
+{
+  uint32_t hi = ready_bitmap >> 32;
+  uint32_t lo = ready_bitmap;
+  uint32_t bit;
+
+  ASSERT (ready_bitmap != 0);
+  if (hi != 0)
+    {
+      asm ("bsrl %1, %0" : "=r" (bit) : "rm" (hi));
+      return bit + 32;
+    }
+  asm ("bsrl %1, %0" : "=r" (bit) : "rm" (lo));
+  return bit;
+}
+
+/* Removes and returns the first thread of the highest priority
+   ready queue.  There must be one. */
+static struct thread *
+ready_pop (void)
+{
+  struct thread *t = list_entry (list_front (&ready_queues[ready_top ()]),
+                                 struct thread, elem);
+  ready_remove (t);
+  return t;
+}
+
+/* Moves T, if it is ready to run, to the queue of the priority it
+   has now, after a donation changed it. */
+static void
+thread_requeue (struct thread *t)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (t->status == THREAD_READY && t->queue_pri != ready_priority (t))
+    {
+      ready_remove (t);
+      ready_push (t);
+    }
+  intr_set_level (old_level);
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -774,86 +814,8 @@ allocate_tid (void)
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof (struct thread, stack);
-/* function to let thread elem save in sleep_list*/
-void push2sleep(int64_t ticks){
-  struct thread *cur = thread_current ();
-  enum intr_level old_level;
-  old_level = intr_disable ();
-
-  /*assign when thread should wake up*/
-  cur->wakeup_ticks = ticks;
-  /*sleep list should be maintained by wakeup_ticks order*/
-  list_insert_ordered (&sleep_list, &cur->elem, &wakeup_tick_compare, NULL);
-
-  thread_block();
-  intr_set_level (old_level);
-}
-/*function to decide sleep_list order*/
-bool wakeup_tick_compare (const struct list_elem *a,
-                              const struct list_elem *b,
-                              void *aux UNUSED)
-{
-  struct thread *thread_a = list_entry (a, struct thread, elem);
-  struct thread *thread_b = list_entry (b, struct thread, elem);
-  return thread_a->wakeup_ticks < thread_b->wakeup_ticks;
-}
-
-/*funcion to wake up threads in sleep_list*/
-void updatesleep(int64_t ticks){
-
-	if(!list_empty(&sleep_list))
-	{
-		struct list_elem *first;
-		struct thread* temp;
 
-		/*find thread which wake up time is up*/
-		for(i=0; i<(int)list_size(&sleep_list)+1; i++)
-		{
-			temp=list_entry(list_front(&sleep_list), struct thread, elem);
 
-			if(temp->wakeup_ticks<=ticks)
-				first=list_pop_front(&sleep_list);
-			else
-				break;
-
-			thread_unblock (temp);
-		}
-	}
-}
-
-
-
-/*function to insert thread's elem in ready_list when we use mlfq*/
-void push2mlfq(struct thread *input)
-{
-	int priority= input->priority;
-	ASSERT(priority>=0 && priority<64);
-	
-	enum intr_level old_level;
-	old_level = intr_disable ();
-	/*mlfqs list should be maintained by priority order*/
-	list_insert_ordered (&ready_list, &input->elem, &priority_compare, NULL);
-	intr_set_level (old_level);
-}
-
-/*function to decide ready_list order*/
-bool priority_compare (const struct list_elem *a,
-                              const struct list_elem *b,
-                              void *aux UNUSED)
-{
-  struct thread *thread_a = list_entry (a, struct thread, elem);
-  struct thread *thread_b = list_entry (b, struct thread, elem);
-  return thread_a->priority > thread_b->priority;
-}
-
-/*function to get thread's elem which has highest priority in ready_list when we use mlfq*/
-struct list_elem * pop_from_mlfq(void)
-{
-  if(list_size(&ready_list))
-	  return list_pop_front(&ready_list);
-  else
-	  return NULL;
-}
 /*function to get number of thread in ready except idle_thread*/
 int num_ready(void)
 {
@@ -861,7 +823,7 @@ int num_ready(void)
 	if(thread_current()==idle_thread)
 		num--;	
 		
-	return num+list_size(&ready_list);
+	return num+ready_cnt;
 }
 /*function to update load_avg*/
 void load_update(void)
@@ -881,15 +843,17 @@ void recent_cpu_update()
 	int front = divide_fp( (2*load), (2*load+int2fp(1)));
 	struct list_elem * e;;
 	struct thread * t;
+	int p;
 
 	/*update thread"s recent_cpu in ready_list*/
-	for(e = list_begin(&ready_list);
-        e != list_end(&ready_list);
-        e = list_next(e))
-	{
+	for(p = PRI_MIN; p <= PRI_MAX; p++)
+	  for(e = list_begin(&ready_queues[p]);
+	      e != list_end(&ready_queues[p]);
+	      e = list_next(e))
+	  {
 		t=list_entry(e, struct thread, elem);
 		t->recent_cpu= multiply_fp(front,t->recent_cpu) +int2fp(t->nice);
-	}
+	  }
 
 	/*update thread"s recent_cpu which is blocked */
 	for(e = list_begin(&block_list);
@@ -924,13 +888,22 @@ void priority_update(void)
 	/*upadte thread's recent_cpu in ready_list*/	
 	enum intr_level old_level;
 	old_level = intr_disable ();
-	struct list_elem * e;;
+	struct list all;
 	struct thread * t;
-	for(e = list_begin(&ready_list);
-        e != list_end(&ready_list);
-        e = list_next(e))
+	int p;
+
+	/*take every ready thread off its queue, highest priority first, so
+	  that threads of equal priority keep their order*/
+	list_init(&all);
+	for(p = PRI_MAX; p >= PRI_MIN; p--)
+		while(!list_empty(&ready_queues[p]))
+			list_push_back(&all, list_pop_front(&ready_queues[p]));
+	ready_bitmap = 0;
+	ready_cnt = 0;
+
+	while(!list_empty(&all))
 	{
-		t=list_entry(e, struct thread, elem);
+		t=list_entry(list_pop_front(&all), struct thread, elem);
 		if(t!=idle_thread)	
 			t->priority = PRI_MAX - fp2int_round(t->recent_cpu/4) - t->nice*2;				
 
@@ -939,10 +912,10 @@ void priority_update(void)
 
 		if(t->priority<PRI_MIN)
 			t->priority=PRI_MIN;
-	 }
 
-	/*resort ready_list because the priority is changed*/
-	list_sort(&ready_list,&priority_compare, NULL );	
+		/*queue it again at the priority it has now*/
+		ready_push(t);
+	 }
 	intr_set_level(old_level);
 
 }
@@ -3,6 +3,7 @@
 
 #include <debug.h>
 #include <list.h>
+#include <hash.h>
 #include <stdint.h>
 #include "threads/synch.h"
 
@@ -15,10 +16,6 @@ enum thread_status
     THREAD_DYING        /* About to be destroyed. */
   };
 
-/* List of processes in THREAD_READY state, that is, processes
- *    that are ready to run but not actually running. */
-struct list ready_list;
-
 /* Thread identifier type.
    You can redefine this to whatever type you like. */
 
@@ -102,8 +99,10 @@ struct thread
     struct list_elem elem2;		/* For donate_list */
     struct list_elem elem3;		/* For block_list */
     struct list donate_list;		/* List of threads which try to acquire the lock								   acquired by this thread */
+    int eff_priority;			/* Priority with donations */
+    struct lock *wait_lock;		/* Lock this thread is waiting for */
+    int queue_pri;			/* Ready queue this thread is on */
     
-   int64_t wakeup_ticks;		/*when wakeup_ticks equals to timer_tick(), thread wakeup */
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
@@ -124,8 +123,23 @@ struct thread
     struct file *exec_file; 
     /*project 3 : supplement table and lock */
     struct lock sp_lock;
-    struct list sp_table;
+    struct hash sp_table;
+    struct list vma_list;		/* file backed regions, by address */
+    struct list frame_list;		/* resident frames, under frame_lock */
+    struct list shared_list;		/* frames shared copy-on-write, owned by
+					   another process */
     void *stack_lim;
+    void *user_esp;			/* user stack pointer at the last system call */
+    void *ra_start;			/* first page of the last read-ahead window */
+    void *ra_next;			/* page just past the last read-ahead window */
+    size_t ra_window;			/* pages to read ahead on the next fault */
+    void *random_last;			/* page of the last fault in a region
+					   advised MADV_RANDOM */
+    size_t rss;				/* frames owned, under frame_lock */
+    size_t rss_peak;			/* largest rss so far */
+    size_t rss_allowance;		/* frames allowed by the page fault
+					   frequency controller */
+    int64_t pff_last;			/* ticks at the last page fault */
     /*****************************************/
 
 
@@ -173,21 +187,9 @@ void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
-void push2sleep(int64_t ticks);
-bool wakeup_tick_compare (const struct list_elem *a,
-                          const struct list_elem *b,
-                          void *aux UNUSED);
-
-void updatesleep(int64_t ticks);
-
 int get_priority(struct thread *target);
-void push2mlfq(struct thread *input);
-bool priority_compare (const struct list_elem *a,
-                              const struct list_elem *b,
-                              void *aux UNUSED);
-
-
-struct list_elem * pop_from_mlfq(void);
+bool thread_update_priority (struct thread *);
+void thread_donate (struct thread *);
 int num_ready(void);
 
 void load_update(void);
@@ -6,6 +6,7 @@
 #include "threads/thread.h"
 #include "vm/page.h"
 #include "vm/frame.h"
+#include "vm/fault.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 
@@ -132,6 +133,8 @@ page_fault (struct intr_frame *f)
   bool write;        /* True: access was write, false: access was read. */
   bool user;         /* True: access by user, false: access by kernel. */
   void *fault_addr;  /* Fault address. */
+  struct fault_time ft;
+  enum fault_class cls;
 
   /* Obtain faulting address, the virtual address that was
      accessed to cause the fault.  It may point to code or to
@@ -146,8 +149,11 @@ page_fault (struct intr_frame *f)
      be assured of reading CR2 before it changed). */
   intr_enable ();
 
-  /* Count page faults. */
+  /* Count page faults, and time them by the path that resolves
+     them. */
   page_fault_cnt++;
+  fault_begin (&ft);
+  frame_pff_fault ();
 
   /* Determine cause. */
   not_present = (f->error_code & PF_P) == 0;
@@ -170,25 +176,23 @@ page_fault (struct intr_frame *f)
   
   /* Locate the page, and load from disk. */
   void *fault_page = pg_round_down(fault_addr);
-  struct sup_page *sp = find_sp(&thread_current()->sp_table, fault_page);
-  if ( sp != NULL && write && (!sp->writable))
+  if (!not_present && write && frame_cow_fault (fault_page))
     {
-      sys_exit(-1);
+      fault_end (&ft, FAULT_COW);
+      return;
     }
-
-
-  if(sp != NULL)
-  {
-    if(load_sp(sp))
-      {
-	return ; 
-      }
-  }
-  if (stack_growth(fault_addr, f))
+  if (load_page (fault_page, write, &cls))
+    {
+      fault_end (&ft, cls);
+      return;
+    }
+  if (stack_growth(fault_addr, f, write))
     {
+      fault_end (&ft, FAULT_STACK);
       return ;
     }
   
+  fault_end (&ft, FAULT_KILL);
   sys_exit(-1);
   /*if(!not_present)
     sys_exit(-1);
@@ -33,14 +33,15 @@ pagedir_destroy (uint32_t *pd)
     return;
 
   ASSERT (pd != base_page_dir);
+  /* Large pages are freed by the frame table, not here. */
   for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
-    if (*pde & PTE_P) 
+    if ((*pde & (PTE_P | PTE_PS)) == PTE_P) 
       {
         uint32_t *pt = pde_get_pt (*pde);
         uint32_t *pte;
         
         for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
-          if (*pte & PTE_P) 
+          if ((*pte & (PTE_P | PTE_SHARED)) == PTE_P) 
             palloc_free_page (pte_get_page (*pte));
         palloc_free_page (pt);
       }
@@ -52,7 +53,9 @@ pagedir_destroy (uint32_t *pd)
    If PD does not have a page table for VADDR, behavior depends
    on CREATE.  If CREATE is true, then a new page table is
    created and a pointer into it is returned.  Otherwise, a null
-   pointer is returned. */
+   pointer is returned.
+   If VADDR is in a large page, returns its PDE instead, whose
+   present, writable, accessed and dirty bits are those of a PTE. */
 static uint32_t *
 lookup_page (uint32_t *pd, const void *vaddr, bool create)
 {
@@ -79,6 +82,8 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
       else
         return NULL;
     }
+  if (*pde & PTE_PS)
+    return pde;
 
   /* Return the page table entry. */
   pt = pde_get_pt (*pde);
@@ -118,6 +123,34 @@ pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool writable)
     return false;
 }
 
+/* Maps user virtual page UPAGE to the kernel page KPAGE read-only
+   in PD, like pagedir_set_page(), but KPAGE is shared with other
+   page directories and is not freed by pagedir_destroy().
+   Returns true if successful, false if memory allocation
+   failed. */
+bool
+pagedir_set_shared_page (uint32_t *pd, void *upage, void *kpage)
+{
+  uint32_t *pte;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (pg_ofs (kpage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (vtop (kpage) >> PTSHIFT < ram_pages);
+  ASSERT (pd != base_page_dir);
+
+  pte = lookup_page (pd, upage, true);
+
+  if (pte != NULL) 
+    {
+      ASSERT ((*pte & PTE_P) == 0);
+      *pte = pte_create_user (kpage, false) | PTE_SHARED;
+      return true;
+    }
+  else
+    return false;
+}
+
 /* Looks up the physical address that corresponds to user virtual
    address UADDR in PD.  Returns the kernel virtual address
    corresponding to that physical address, or a null pointer if
@@ -130,16 +163,52 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
   ASSERT (is_user_vaddr (uaddr));
   
   pte = lookup_page (pd, uaddr, false);
-  if (pte != NULL && (*pte & PTE_P) != 0)
+  if (pte != NULL && (*pte & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
+    return pte_get_page (*pte) + ((uintptr_t) uaddr & (PTSPAN - 1));
+  else if (pte != NULL && (*pte & PTE_P) != 0)
     return pte_get_page (*pte) + pg_ofs (uaddr);
   else
     return NULL;
 }
 
+/* Maps the PTSPAN bytes of user virtual memory at UPAGE to the
+   physically contiguous KPAGE in PD, as one large page.  Both must
+   be aligned to PTSPAN.  Fails if a page of the range is already
+   mapped; a page table left with no present page is freed.  The
+   CPU must have CR4.PSE set. */
+bool
+pagedir_set_large_page (uint32_t *pd, void *upage, void *kpage,
+                        bool writable)
+{
+  uint32_t *pde;
+
+  ASSERT ((uintptr_t) upage % PTSPAN == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (pd != base_page_dir);
+
+  pde = pd + pd_no (upage);
+  if (*pde & PTE_PS)
+    return false;
+  if (*pde != 0)
+    {
+      uint32_t *pt = pde_get_pt (*pde);
+      uint32_t *pte;
+
+      for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
+        if (*pte & PTE_P)
+          return false;
+      palloc_free_page (pt);
+    }
+  *pde = pde_create_large (kpage, writable);
+  invalidate_pagedir (pd);
+  return true;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
    directory PD.  Later accesses to the page will fault.  Other
    bits in the page table entry are preserved.
-   UPAGE need not be mapped. */
+   UPAGE need not be mapped.  If UPAGE is in a large page, the
+   whole large page is unmapped. */
 void
 pagedir_clear_page (uint32_t *pd, void *upage) 
 {
@@ -151,7 +220,12 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   pte = lookup_page (pd, upage, false);
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
-      *pte &= ~PTE_P;
+      /* A PDE left with PTE_PS would not be taken for a page
+         table. */
+      if (*pte & PTE_PS)
+        *pte = 0;
+      else
+        *pte &= ~PTE_P;
       invalidate_pagedir (pd);
     }
 }
@@ -214,6 +288,31 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
     }
 }
 
+/* Returns true if the PTE for virtual page VPAGE in PD is present
+   and writable. */
+bool
+pagedir_is_writable (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+   VPAGE in PD, keeping its accessed and dirty bits. */
+void
+pagedir_set_writable (uint32_t *pd, const void *vpage, bool writable) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  if (pte != NULL) 
+    {
+      if (writable)
+        *pte |= PTE_W;
+      else 
+        *pte &= ~(uint32_t) PTE_W; 
+      invalidate_pagedir (pd);
+    }
+}
+
 /* Loads page directory PD into the CPU's page directory base
    register. */
 void
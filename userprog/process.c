@@ -22,8 +22,20 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/vma.h"
 
 static thread_func start_process NO_RETURN;
+static thread_func start_fork NO_RETURN;
+static bool fork_load (struct thread *parent);
+
+/* Handed from process_fork() to the child it creates. */
+struct fork_info
+  {
+    struct semaphore sema;      /* Upped when the child is set up. */
+    struct thread *parent;      /* Process being forked. */
+    struct intr_frame if_;      /* Parent's user context. */
+    bool success;               /* Child set up successfully? */
+  };
 static bool load (char *cmdline, void (**eip) (void), void **esp);
 
 /* Starts a new thread running a user program loaded from
@@ -121,6 +133,104 @@ start_process (void *f_name)
   NOT_REACHED ();
 }
 
+/* Starts a new process that is a copy of the current one, resuming
+   from the user context IF_ with 0 as the return value.  Its address
+   space shares the frames of the current process copy-on-write.
+   Returns the new process's thread id, or TID_ERROR if it cannot be
+   created. */
+tid_t
+process_fork (struct intr_frame *if_)
+{
+  struct thread *curr = thread_current ();
+  struct fork_info *fi;
+  tid_t tid;
+
+  fi = (struct fork_info *) malloc (sizeof (struct fork_info));
+  if (fi == NULL)
+    return TID_ERROR;
+  sema_init (&fi->sema, 0);
+  fi->parent = curr;
+  fi->if_ = *if_;
+
+  tid = thread_create (curr->name, PRI_DEFAULT, start_fork, fi);
+  if (tid == TID_ERROR)
+    {
+      free (fi);
+      return tid;
+    }
+
+  /* The child copies our address space, which must not change
+     until it is done. */
+  sema_down (&fi->sema);
+  if (!fi->success)
+    tid = TID_ERROR;
+
+  free (fi);
+  return tid;
+}
+
+/* A thread function that duplicates the address space of the
+   forking process and returns to user mode in the copy. */
+static void
+start_fork (void *fi_)
+{
+  struct fork_info *fi = fi_;
+  struct intr_frame if_ = fi->if_;
+  bool success;
+
+  success = fork_load (fi->parent);
+  fi->success = success;
+  sema_up (&fi->sema);
+
+  if (!success)
+    sys_exit (-1);
+
+  /* fork() returns 0 in the child. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Sets up the current thread as a copy of PARENT: its page
+   directory, open files and address space.  Resident pages are
+   shared copy-on-write, swapped out pages are copied.  Returns true
+   if successful. */
+static bool
+fork_load (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    return false;
+  process_activate ();
+  if (!init_spt (t))
+    return false;
+
+  t->exec_file = file_reopen (parent->exec_file);
+  if (t->exec_file == NULL)
+    return false;
+  file_deny_write (t->exec_file);
+
+  for (e = list_begin (&parent->fd_list); e != list_end (&parent->fd_list);
+       e = list_next (e))
+    {
+      struct file *pfile = list_entry (e, struct file, elem);
+      struct file *file = file_reopen (pfile);
+      if (file == NULL)
+        return false;
+      file->fd = pfile->fd;
+      file_seek (file, file_tell (pfile));
+      list_push_back (&t->fd_list, &file->elem);
+    }
+  t->fd_num = parent->fd_num;
+  t->stack_lim = parent->stack_lim;
+
+  return (fork_vma (parent, t->exec_file) && frame_fork (parent)
+          && fork_spt (parent));
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1. If TID is invalid or if it was not a
@@ -339,6 +449,10 @@ load (char *file_name, void (**eip) (void), void **esp)
     goto done;
   process_activate ();
 
+  /* Allocate supplement page table. */
+  if (!init_spt (t))
+    goto done;
+
 
   /* Before file_open, find function name*/
   char temp[16];
@@ -629,44 +743,9 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
-  file_seek (file, ofs);
-  while (read_bytes > 0 || zero_bytes > 0) 
-    {
-      /* Do calculate how to fill this page.
-         We will read PAGE_READ_BYTES bytes from FILE
-         and zero the final PAGE_ZERO_BYTES bytes. */
-      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-      size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-      /* Get a page of memory. */
-      /*uint8_t *kpage = palloc_get_page (PAL_USER);
-      if (kpage == NULL)
-        return false;*/
-
-      /* Load this page. */
-      /*if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
-        {
-          palloc_free_page (kpage);
-          return false; 
-        }
-      memset (kpage + page_read_bytes, 0, page_zero_bytes);*/
-
-      /* Add the page to the process's address space. */
-      /*if (!install_page (upage, kpage, writable)) 
-        {
-          palloc_free_page (kpage);
-          return false; 
-        }*/
-      if(!add_exefile_sp(file, ofs, upage, page_read_bytes, page_zero_bytes, writable,false))
-	return false;
-      ofs += page_read_bytes;
-
-      /* Advance. */
-      read_bytes -= page_read_bytes;
-      zero_bytes -= page_zero_bytes;
-      upage += PGSIZE;
-    }
-  return true;
+  /* The whole segment is one region, its pages are read from
+     FILE on demand. */
+  return add_vma (file, ofs, upage, read_bytes, zero_bytes, writable, false);
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <round.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -13,6 +14,8 @@
 #include "userprog/pagedir.h"
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/vma.h"
+#include "vm/fault.h"
 #include "lib/user/syscall.h"
 
 static void syscall_handler (struct intr_frame *);
@@ -29,6 +32,7 @@ syscall_handler (struct intr_frame *f UNUSED)
   struct lock sys_lock;
   lock_init(&sys_lock);
   curr = thread_current();
+  curr->user_esp = f->esp;
 
   /* Variables uesd by system calls of several kinds*/
 	int fd;
@@ -57,6 +61,56 @@ syscall_handler (struct intr_frame *f UNUSED)
  		f->eax = process_execute( *(char **)(f->esp + 4));
 		break;
 	
+	case SYS_FORK:
+		f->eax = process_fork (f);
+		break;
+
+	// int vmstat (struct fault_stat stats[FAULT_CLASS_CNT])
+	case SYS_VMSTAT:
+	  isUseraddr(1,1,f);
+	  {
+		struct fault_stat *stats = *(struct fault_stat **)(f->esp+4);
+		struct fault_stat st;
+		int c;
+		if((uint32_t)(stats + FAULT_CLASS_CNT) > (uint32_t) PHYS_BASE)
+		  sys_exit(-1);
+		/* snapshot one class at a time, faults on STATS count too */
+		for(c = 0; c < FAULT_CLASS_CNT; c++)
+		  {
+			fault_get_stat(c, &st);
+			stats[c] = st;
+		  }
+		f->eax = FAULT_CLASS_CNT;
+	  }
+		break;
+
+	// int madvise (void *addr, size_t length, int advice)
+	case SYS_MADVISE:
+	  isUseraddr(3,0,f);
+		f->eax = page_advise(*(void **)(f->esp+4), *(size_t *)(f->esp+8),
+				     *(int *)(f->esp+12)) ? 0 : -1;
+		break;
+
+	// int msync (void *addr, size_t length)
+	case SYS_MSYNC:
+	  isUseraddr(2,0,f);
+		f->eax = page_msync(*(void **)(f->esp+4), *(size_t *)(f->esp+8)) ? 0 : -1;
+		break;
+
+	// int rssstat (struct rss_stat *)
+	case SYS_RSSSTAT:
+	  isUseraddr(1,1,f);
+	  {
+		struct rss_stat *st = *(struct rss_stat **)(f->esp+4);
+		struct rss_stat s;
+		if((uint32_t)(st + 1) > (uint32_t) PHYS_BASE)
+		  sys_exit(-1);
+		frame_get_rss(&s);
+		*st = s;
+		f->eax = 0;
+	  }
+		break;
+
 	//bool create (const char *file, unsigned initial_size)
 	case SYS_CREATE:
 	  isUseraddr(2,1,f);
@@ -75,23 +129,13 @@ syscall_handler (struct intr_frame *f UNUSED)
 	//int read (int fd, void *buffer, unsigned size)
 	case SYS_READ:
 	  isUseraddr(3,2,f);
-  		lock_acquire(&sys_lock);
 		fd = *(int*)(f->esp+4);
 		buffer = *(char**)(f->esp+8);	
 		length = *(int*)(f->esp+12);
-		void *upage = pg_round_down(buffer);
-		void *kpage = pagedir_get_page(thread_current()->pagedir, upage);
-		struct frame *fr = find_frame(kpage);
-		if (fr == NULL)
-		{
-		  sys_exit(-1);
-		  //thread_exit();
-		  
-		}
-		if (!fr->writable)
-		{
+		/* bring in the whole buffer before taking the lock */
+		if (!pin_user_range(buffer, length, true))
 		  sys_exit(-1);
-		}	
+  		lock_acquire(&sys_lock);
 		/* stdin case*/
 		if(fd == 0){
 			int i = 0;
@@ -128,6 +172,7 @@ syscall_handler (struct intr_frame *f UNUSED)
 			}
 			if(suc==false){
 				lock_release(&sys_lock);
+				unpin_user_range(buffer, length);
 				f->eax = -1;
 				break;
 			}
@@ -135,6 +180,7 @@ syscall_handler (struct intr_frame *f UNUSED)
 			f->eax = file_read(file, buffer, length);
 		}
 		lock_release(&sys_lock);
+		unpin_user_range(buffer, length);
 		break;
 
 	//int filesize (int fd)
@@ -199,31 +245,19 @@ syscall_handler (struct intr_frame *f UNUSED)
     // int write (int fd, const void *buffer, unsigned length);
 	case SYS_WRITE:
 	  isUseraddr(3,2,f);
-		lock_acquire(&sys_lock);
-
 		fd = *(int*)(f->esp+4);
 		buffer = *(char**)(f->esp+8);	
 		length = *(int*)(f->esp+12);
 
-		/* delete mmaped page to allow overwrite */	
-		if (!list_empty(&curr->sp_table))
-		  {
-		    find = list_begin(&curr->sp_table);
-		    while(find != list_end(&curr->sp_table))
-		      {
-			struct sup_page *sp_rm = list_entry(find, struct sup_page, elem);
-			struct list_elem *next = list_tail(&curr->sp_table);
-			if(find != list_prev(list_end(&curr->sp_table)))
-			  next = list_next(find);
-			if (sp_rm->fd == fd)
-			  {
-			    remove_sp(sp_rm);
-			  }
-			find = next;
-		      }
-		  }
 		/* delete mapped frame to allow overwrite */
 		unmap_frames (fd);
+		/* delete mmaped region to allow overwrite */	
+		remove_vma (fd);
+
+		/* bring in the whole buffer before taking the lock */
+		if (!pin_user_range(buffer, length, false))
+		  sys_exit(-1);
+		lock_acquire(&sys_lock);
 		
 		/*stdin case*/
 		if(fd == 0)
@@ -247,6 +281,7 @@ syscall_handler (struct intr_frame *f UNUSED)
 			}
 		}
 		lock_release(&sys_lock);
+		unpin_user_range(buffer, length);
 		break;
 
 	//void seek (int fd, unsigned position)
@@ -294,23 +329,12 @@ syscall_handler (struct intr_frame *f UNUSED)
 	   
 	  mapid_t mapID =*(mapid_t *) (f->esp+4);
 
-	  /* Remove all mmaped pages corresponding to mapID. */
-	  if (!list_empty(&curr->sp_table))
-	  {
-	    find = list_begin(&curr->sp_table);
-	    while(find != list_end(&curr->sp_table))
-		  {
-			struct sup_page *sp_rm = list_entry(find, struct sup_page, elem);
-			struct list_elem *next = list_tail(&curr->sp_table);
-			if(find != list_prev(list_end(&curr->sp_table)))
-			  next = list_next(find);
-			if (sp_rm->fd == mapID)
-			    load_sp(sp_rm);
-			find = next;
-	  	  }
-	  }
-	  /* Remove all mmaped frames corresponding to mapID. */	  
+	  /* Remove all mmaped frames corresponding to mapID, writing
+	     back the dirty ones.  Pages that are not resident were
+	     written back when evicted. */	  
 	  unmap_frames (mapID);
+	  /* Remove the mmaped region corresponding to mapID. */
+	  remove_vma (mapID);
 	  lock_release(&sys_lock);
 	  break;
 
@@ -371,48 +395,17 @@ syscall_handler (struct intr_frame *f UNUSED)
 	      break;
 	    }
 
-	  struct sup_page *sp = find_sp(&curr->sp_table, addr);
-	  if(sp != NULL)
+	  /* One region describes the whole file, its pages are read on
+	     demand.  Fails if it overlaps another region. */
+	  if(!add_vma(file, 0, (uint8_t *) addr, file_length(file),
+		      ROUND_UP(file_length(file), PGSIZE) - file_length(file), true, true))
 	    {
 	      lock_release(&sys_lock);
 	      f->eax = -1;
 	      break;
 	    }
-
-	  uint32_t read_bytes = (file_length(file) < PGSIZE) ? file_length(file) : PGSIZE ;
-	 
-	  /* Add pages corresponding to file to be memory-mapped. 
- * 	     First, add one page and see if the file size is bigger than the page size.
- * 	     If it is bigger, then keep adding pages until it reaches end of file. */ 
-	  add_exefile_sp(file, 0, addr, read_bytes, PGSIZE - read_bytes, true, true);
-	  int cnt = 0;
-	  while(PGSIZE == read_bytes)
-	    {
-	      cnt += 1;
-	      sp = find_sp(&curr->sp_table, addr + cnt*PGSIZE);
-	      if(sp!=NULL)
-		{
-		  /* Remove already-mapped pages if overlap occurs. */
-		  struct list_elem *e;
-		  for (e = list_begin(&curr->sp_table);
-			e != list_end(&curr->sp_table);
-			e = list_next(e))
-		    {
-		      struct sup_page *sp_rm = list_entry(e, struct sup_page, elem);
-		      if (sp_rm->fd == fd)
-		        remove_sp(sp_rm);
-		    }
-		  lock_release(&sys_lock);
-		  f->eax = -1;
-		  goto error;
-		}
-	      read_bytes = (file_length(file) < PGSIZE * (cnt+1)) ? file_length(file) - cnt* PGSIZE : PGSIZE;
-	      add_exefile_sp(file, cnt*PGSIZE, addr+cnt*PGSIZE, read_bytes, PGSIZE-read_bytes, true, true);
-	    } 
 	  f->eax = file->fd;
 	  lock_release(&sys_lock);
-	  
-  error :
 	  break;
 		
   case SYS_REMOVE :
@@ -462,13 +455,10 @@ isUseraddr(int argnum, int pointer_index, struct intr_frame *f)
 		// char pointer validation check
 		if(!pagedir_get_page(curr->pagedir, *temp))
 		  {
-		    struct supplement_page *sp = find_sp(&thread_current()->sp_table, pg_round_down(*temp));
-		    if(sp!=NULL)
-		      {
-			load_sp(sp);
-			return;
-		      }
-		    if(!stack_growth(*temp,f))
+		    enum fault_class cls;
+		    if(load_page(pg_round_down(*temp), false, &cls))
+		      return;
+		    if(!stack_growth(*temp,f,false))
 		      sys_exit(-1);
 		  }
 	}
@@ -0,0 +1,92 @@
+#include "vm/fault.h"
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+
+static int hist_bucket(uint64_t x, int cnt);
+static void print_hist(const char *unit, const uint32_t *hist, int cnt);
+
+/*latency statistics, per fault class*/
+struct fault_stat fault_stats[FAULT_CLASS_CNT];
+
+static const char *fault_names[FAULT_CLASS_CNT] =
+{
+	"exe", "mmap", "swap", "zero", "stack", "cow", "evict", "kill", "large"
+};
+
+/*histogram bucket of X: 0 for 0, B for [2**(B-1), 2**B), capped at
+  the last of CNT buckets*/
+static int
+hist_bucket(uint64_t x, int cnt)
+{
+	int b = 0;
+	while(x != 0 && b < cnt - 1)
+	{
+		x >>= 1;
+		b++;
+	}
+	return b;
+}
+
+/*start timing a fault*/
+void
+fault_begin(struct fault_time *ft)
+{
+	ft->ticks = timer_ticks();
+	ft->tsc = timer_tsc();
+}
+
+/*account the fault started at FT to class CLS.  Faults can nest, an
+  eviction is timed inside the fault that needed the frame, so each
+  class counts its own path including what it waited for. */
+void
+fault_end(const struct fault_time *ft, enum fault_class cls)
+{
+	uint64_t cycles = timer_tsc() - ft->tsc;
+	uint64_t ticks = timer_ticks() - ft->ticks;
+	struct fault_stat *st = &fault_stats[cls];
+	enum intr_level old_level = intr_disable();
+	st->cnt++;
+	st->ticks += ticks;
+	st->cycles += cycles;
+	st->tick_hist[hist_bucket(ticks, FAULT_TICK_BUCKETS)]++;
+	st->cycle_hist[hist_bucket(cycles, FAULT_CYCLE_BUCKETS)]++;
+	intr_set_level(old_level);
+}
+
+/*copy the statistics of class CLS to ST*/
+void
+fault_get_stat(enum fault_class cls, struct fault_stat *st)
+{
+	enum intr_level old_level = intr_disable();
+	*st = fault_stats[cls];
+	intr_set_level(old_level);
+}
+
+/*print the non-empty buckets of HIST, labelled by their lower bound*/
+static void
+print_hist(const char *unit, const uint32_t *hist, int cnt)
+{
+	int b;
+	printf("  %s:", unit);
+	for(b = 0; b < cnt; b++)
+		if(hist[b] != 0)
+			printf(" %llu:%u", b == 0 ? 0ULL : 1ULL << (b - 1), hist[b]);
+	printf("\n");
+}
+
+void
+fault_print_stats(void)
+{
+	int c;
+	for(c = 0; c < FAULT_CLASS_CNT; c++)
+	{
+		struct fault_stat *st = &fault_stats[c];
+		if(st->cnt == 0)
+			continue;
+		printf("Fault: %s %llu faults, %llu ticks, %llu cycles (%llu avg)\n",
+			fault_names[c], st->cnt, st->ticks, st->cycles, st->cycles / st->cnt);
+		print_hist("ticks", st->tick_hist, FAULT_TICK_BUCKETS);
+		print_hist("cycles", st->cycle_hist, FAULT_CYCLE_BUCKETS);
+	}
+}
@@ -0,0 +1,18 @@
+#ifndef VM_FAULT_H
+#define VM_FAULT_H
+#include <stdint.h>
+#include <vmstat.h>
+
+/* start of a timed fault, in timer ticks and TSC cycles */
+struct fault_time
+{
+  int64_t ticks;           /*timer_ticks() at the start*/
+  uint64_t tsc;            /*time stamp counter at the start*/
+};
+
+void fault_begin(struct fault_time *ft);
+void fault_end(const struct fault_time *ft, enum fault_class cls);
+void fault_get_stat(enum fault_class cls, struct fault_stat *st);
+void fault_print_stats(void);
+
+#endif /* vm/fault.h */
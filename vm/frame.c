@@ -1,104 +1,571 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/vma.h"
+#include "vm/fault.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/pte.h"
+#include "threads/init.h"
+#include "filesys/file.h"
 #include "threads/synch.h"
 #include "userprog/pagedir.h"
 #include "threads/interrupt.h"
+#include "devices/timer.h"
 #include <stdio.h>
+#include <string.h>
+#include <round.h>
 #include <list.h>
+#include <hash.h>
 
-struct list ft_list;
-struct list_elem *next_vict_elem;
+#define FRAME_NONE ((size_t) -1)
+#define LARGE_PAGE_CNT (PTSPAN / PGSIZE)	/* frames in a 4 MB page */
+#define WRITEBACK_BATCH 8			/* pages written back by one write */
+
+struct frame *frame_table;		/* one entry per user pool page */
+size_t frame_cnt;			/* number of entries in frame_table */
+uint8_t *frame_base;			/* kernel address of first user pool page */
+size_t frame_used;			/* number of entries in use */
+size_t clock_hand;			/* index of next victim candidate */
 struct lock frame_lock;
 
+/* Page cleaner.  Watermarks are in free frames, set with the
+   kernel command-line options -vm-low and -vm-high. */
+size_t frame_low_watermark = 8;
+size_t frame_high_watermark = 16;
+struct semaphore cleaner_sema;		/* upped to wake the cleaner */
+bool cleaner_woken;			/* cleaner_sema already upped */
+long long cleaned_cnt;			/* frames freed by the cleaner */
+long long cow_copy_cnt;			/* pages copied on write after fork */
+
+/* Zero page.  Read faults on pages that start out zero map this one
+   read-only kernel page; a frame is allocated on the first write. */
+void *zero_page;
+long long zero_map_cnt;			/* read faults served by zero_page */
+long long zero_write_cnt;		/* zero pages then written */
+
+/* Large pages.  A 4 MB block of a region is mapped with one large
+   page on its first fault when the whole block is in the region and
+   none of it was brought in yet. */
+bool frame_large_pages;
+long long large_map_cnt;		/* large pages mapped */
+
+/* Page replacement policy.  The frame table calls the hooks with
+   frame_lock held. */
+struct frame_policy
+{
+	const char *name;
+	void (*init)(void);
+	void (*on_map)(struct frame *f);	/* F got a new page */
+	void (*on_access_scan)(struct frame *f, bool accessed);
+						/* accessed bit of F sampled and cleared */
+	struct frame *(*pick_victim)(void);	/* frame to evict, NULL if none */
+	void (*on_evict)(struct frame *f);	/* page of F was evicted */
+	void (*on_free)(struct frame *f);	/* F gives up its page */
+};
+
+static void policy_nop(void);
+static void policy_nop_frame(struct frame *f);
+static void policy_nop_scan(struct frame *f, bool accessed);
+static struct frame *clock_pick_victim(void);
+static void wsclock_on_map(struct frame *f);
+static void wsclock_on_access_scan(struct frame *f, bool accessed);
+static struct frame *wsclock_pick_victim(void);
+static void twoq_init(void);
+static void twoq_on_map(struct frame *f);
+static void twoq_on_access_scan(struct frame *f, bool accessed);
+static struct frame *twoq_pick_victim(void);
+static void twoq_on_evict(struct frame *f);
+static void twoq_on_free(struct frame *f);
+
+/* second chance clock, the default */
+static const struct frame_policy clock_policy =
+  {"clock", policy_nop, policy_nop_frame, policy_nop_scan,
+   clock_pick_victim, policy_nop_frame, policy_nop_frame};
+/* clock over the last use time of the frames, preferring clean
+   frames out of the working set */
+static const struct frame_policy wsclock_policy =
+  {"wsclock", policy_nop, wsclock_on_map, wsclock_on_access_scan,
+   wsclock_pick_victim, policy_nop_frame, policy_nop_frame};
+/* 2Q, pages referenced once are evicted first */
+static const struct frame_policy twoq_policy =
+  {"2q", twoq_init, twoq_on_map, twoq_on_access_scan,
+   twoq_pick_victim, twoq_on_evict, twoq_on_free};
+
+static const struct frame_policy *policies[] =
+  {&clock_policy, &wsclock_policy, &twoq_policy};
+static const struct frame_policy *policy = &clock_policy;
+long long evict_cnt;			/* frames evicted */
+
+/* Frames left behind by sequential access, see madvise().  They are
+   evicted ahead of the policy's victims unless accessed again. */
+struct list cold_list;
+long long cold_evict_cnt;		/* cold frames evicted */
+
+/* Resident sets.  Each process owns the frames on its frame_list,
+   counted in rss, against an allowance set by the page fault frequency
+   controller: faults less than PFF_LOW ticks apart grow it by PFF_GROW
+   frames, a fault after more than PFF_HIGH ticks shrinks it by a
+   quarter.  Victims are taken from processes over their allowance
+   first.  A process at the hard cap replaces its own frames. */
+#define PFF_LOW 1
+#define PFF_HIGH 25
+#define PFF_GROW 8
+#define RSS_MIN 16			/* least allowance */
+
+size_t frame_rss_max;
+size_t rss_over_cnt;			/* processes over their allowance */
+size_t rss_hand;			/* index of next over allowance candidate */
+long long rss_victim_cnt;		/* victims from processes over allowance */
+size_t rss_peak;			/* largest resident set so far */
+
+/* Write-back of memory mapped pages on munmap() and msync().  Only
+   dirty pages are written, runs of them adjacent in the file with one
+   file_write_at(). */
+long long writeback_page_cnt;		/* pages written back */
+long long writeback_cnt;		/* file_write_at() calls */
+
+/* Eviction writes its victims out without frame_lock, the frames
+   pinned in transit meanwhile. */
+size_t transit_cnt;			/* frames in transit */
+struct condition transit_done;		/* signaled when a batch is written */
+long long transit_wait_cnt;		/* faults that waited for a write */
+
+static size_t frame_index(void *frame_addr);
+static bool scan_accessed(struct frame *f);
+static size_t select_victims(struct frame **victs, size_t max);
+static void set_frame(struct frame *f, void *upage, bool mmapFlag, bool writable);
+static bool evictable(struct frame *f);
+static size_t evict_frames(struct frame **victs);
+static void release_frame(struct frame *f);
+static void unlink_frame(struct frame *f);
+static void drop_frame(struct frame *f, struct list *writeback);
+static void write_back_frames(struct list *writeback);
+static bool writeback_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+static bool frame_follows(struct frame *a, struct frame *b);
+static void write_back_run(struct frame **run, size_t cnt, uint8_t *buffer);
+static void drop_share(struct frame_share *s);
+static struct frame_share *find_share(struct frame *f, struct thread *t);
+static bool share_frame(struct frame *f, struct thread *parent);
+static size_t free_frames(void);
+static void frame_cleaner(void *aux UNUSED);
+static void wake_cleaner(void);
+static struct frame *transit_frame(struct thread *t);
+static void wait_transit(struct thread *t);
+static bool grow_stack(void *fault_addr, void *esp, bool write);
+static bool pin_page(void *upage, bool writable);
+static bool fault_in_page(void *upage, bool writable);
+static size_t frame_page_cnt(struct frame *f);
+static bool rss_over(struct thread *t);
+static bool rss_capped(struct thread *t, size_t cnt);
+static void rss_charge(struct thread *t, struct frame *f);
+static void rss_uncharge(struct frame *f);
+static void rss_set_allowance(struct thread *t, size_t allowance);
+static struct frame *rss_pick_victim(struct thread *only);
+static struct frame *cold_pick_victim(struct thread *only);
+static struct frame *frame_holding(void *kpage);
+static struct frame *add_large_frame(void *kpage, void *block, bool writable);
+static bool copy_large_frame(struct frame *f);
+
 /*initialize the frame */
 void
 frame_init(void)
 {
-	list_init(&ft_list);
-	next_vict_elem = NULL;
+	size_t i;
+	frame_base = palloc_user_base();
+	frame_cnt = palloc_user_page_cnt();
+	frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+		DIV_ROUND_UP(frame_cnt * sizeof(struct frame), PGSIZE));
+	for(i = 0; i < frame_cnt; i++)
+	{
+		frame_table[i].frame_addr = frame_base + i * PGSIZE;
+		list_init(&frame_table[i].sharers);
+		cond_init(&frame_table[i].transit);
+	}
+	frame_used = 0;
+	clock_hand = 0;
 	lock_init(&frame_lock);
+	cond_init(&transit_done);
+	list_init(&cold_list);
+	zero_page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	policy->init();
+}
+
+/*choose the replacement policy by NAME, before frame_init().  False if
+  there is no such policy. */
+bool
+frame_set_policy(const char *name)
+{
+	size_t i;
+	for(i = 0; i < sizeof policies / sizeof *policies; i++)
+		if(!strcmp(policies[i]->name, name))
+		{
+			policy = policies[i];
+			return true;
+		}
+	return false;
+}
+
+/*convert the frame address to the index of frame table,
+  FRAME_NONE if it is not a user pool page */
+static size_t
+frame_index(void *frame_addr)
+{
+	if((uint8_t *)frame_addr < frame_base)
+		return FRAME_NONE;
+	size_t idx = ((uint8_t *)frame_addr - frame_base) >> PGBITS;
+	return idx < frame_cnt ? idx : FRAME_NONE;
 }
 
 /*find the frame using the frame address */
 struct frame *
 find_frame(void *frame_addr)
 {
-	struct list_elem *e;
+	size_t idx = frame_index(frame_addr);
+	if(idx == FRAME_NONE || !frame_table[idx].in_use)
+		return NULL;
+	return &frame_table[idx];
+}
+
+/*clockwise algorithm*/
+void
+clockwise_victim(void)
+{
+	if(++clock_hand >= frame_cnt)
+		clock_hand = 0;
+}
+
+/*true if the frame can be evicted.  A frame whose page is not mapped
+  to it yet is still being loaded by its owner, and a frame shared
+  copy-on-write is mapped by several processes. */
+static bool
+evictable(struct frame *f)
+{
+	return f->in_use && !f->in_transit && !f->large && f->pin_cnt == 0 && f->ref_cnt == 1
+		&& pagedir_get_page(f->t->pagedir, f->page_addr) == f->frame_addr;
+}
+
+/*read and clear the accessed bit of F, telling the policy*/
+static bool
+scan_accessed(struct frame *f)
+{
+	bool accessed = pagedir_is_accessed(f->t->pagedir, f->page_addr);
+	if(accessed)
+		pagedir_set_accessed(f->t->pagedir, f->page_addr, false);
+	policy->on_access_scan(f, accessed);
+	return accessed;
+}
+
+/*pop the first cold frame of ONLY, or of anyone if ONLY is NULL, that
+  was not accessed since it was marked.  Cold frames of others are left
+  on the list, the ones passed over that were accessed are dropped. */
+static struct frame *
+cold_pick_victim(struct thread *only)
+{
+	struct list_elem *e = list_begin(&cold_list);
+	while(e != list_end(&cold_list))
+	{
+		struct frame *f = list_entry(e, struct frame, cold_elem);
+		e = list_next(e);
+		if(only != NULL && f->t != only)
+			continue;
+		list_remove(&f->cold_elem);
+		f->cold = false;
+		if(evictable(f) && !pagedir_is_accessed(f->t->pagedir, f->page_addr))
+		{
+			cold_evict_cnt++;
+			return f;
+		}
+	}
+	return NULL;
+}
+
+/*select the victim.  A process at the hard cap replaces one of its own
+  frames, cold ones first.  Otherwise a cold frame not accessed since it
+  was marked, one of a process over its allowance, or else the one of
+  the replacement policy.  A capped process none of whose frames can be
+  evicted takes one of those rather than fail. */
+struct frame *
+select_victim(void)
+{
+	struct thread *t = thread_current();
 	struct frame *f;
-	lock_acquire(&frame_lock);
-	if(!list_empty(&ft_list))
+	if(rss_capped(t, 1))
+	{
+		if((f = cold_pick_victim(t)) != NULL)
+			return f;
+		if((f = rss_pick_victim(t)) != NULL)
+			return f;
+	}
+	if((f = cold_pick_victim(NULL)) != NULL)
+		return f;
+	if(rss_over_cnt > 0 && (f = rss_pick_victim(NULL)) != NULL)
+		return f;
+	if(frame_used > 0)
+		return policy->pick_victim();
+	return NULL;
+}
+
+static void
+policy_nop(void)
+{
+}
+
+static void
+policy_nop_frame(struct frame *f UNUSED)
+{
+}
+
+static void
+policy_nop_scan(struct frame *f UNUSED, bool accessed UNUSED)
+{
+}
+
+/*select the victim using the second chance and clock algorithm*/
+static struct frame *
+clock_pick_victim(void)
+{
+	struct frame *f;
+	size_t scan;
+	/* two turns of the clock clear every accessed bit */
+	for(scan = 0; scan <= 2 * frame_cnt; scan++)
+	{
+		f = &frame_table[clock_hand];
+		clockwise_victim();
+		if(evictable(f) && !scan_accessed(f))
+			return f;
+	}
+	return NULL;
+}
+
+/* WSClock.  A frame not accessed for WSCLOCK_TAU ticks is out of its
+   process's working set.  The hand takes the first such frame that is
+   clean, so it costs no write; failing that, the first one that is
+   dirty, and failing that the least recently used frame. */
+#define WSCLOCK_TAU 50
+
+static void
+wsclock_on_map(struct frame *f)
+{
+	f->last_use = timer_ticks();
+}
+
+static void
+wsclock_on_access_scan(struct frame *f, bool accessed)
+{
+	if(accessed)
+		f->last_use = timer_ticks();
+}
+
+static struct frame *
+wsclock_pick_victim(void)
+{
+	int64_t now = timer_ticks();
+	struct frame *f, *dirty_old = NULL, *oldest = NULL;
+	size_t scan;
+	/* the second turn only runs if every frame was accessed */
+	for(scan = 0; scan < 2 * frame_cnt; scan++)
 	{
-		e = list_front(&ft_list);
-		while(e!=list_end(&ft_list))
+		if(scan >= frame_cnt && oldest != NULL)
+			break;
+		f = &frame_table[clock_hand];
+		clockwise_victim();
+		if(!evictable(f) || scan_accessed(f))
+			continue;
+		if(now - f->last_use > WSCLOCK_TAU)
 		{
-			f = list_entry(e, struct frame, elem);
-			if(f->frame_addr == frame_addr)
-			{
-				lock_release(&frame_lock);
+			if(!pagedir_is_dirty(f->t->pagedir, f->page_addr))
 				return f;
-			}
-			e = list_next(e);
+			if(dirty_old == NULL)
+				dirty_old = f;
 		}
+		if(oldest == NULL || f->last_use < oldest->last_use)
+			oldest = f;
 	}
+	return dirty_old != NULL ? dirty_old : oldest;
+}
 
-			lock_release(&frame_lock);
-	return NULL;
+/* 2Q.  A newly mapped page enters A1, a FIFO whose accessed bits are
+   ignored, so a scan touching many pages once only churns A1.  Pages
+   evicted from A1 are remembered in the ghost queue A1out; a page
+   that faults again while remembered was reused and goes to Am, which
+   is run as a clock.  A1 is kept to a quarter of the frames.  A1out is
+   a ring, so the oldest ghost is forgotten first, and each ghost is
+   also on a bucket list by owner and address, so a fault finds it
+   without a scan. */
+struct twoq_ghost
+{
+	tid_t tid;			/* owner of the evicted page */
+	void *upage;			/* address of the evicted page, or NULL */
+	struct list_elem elem;		/* element of its bucket */
+};
+
+struct list twoq_a1;			/* pages referenced once, FIFO */
+struct list twoq_am;			/* pages referenced again */
+size_t twoq_a1_cnt;			/* number of frames in twoq_a1 */
+struct twoq_ghost *twoq_ghosts;		/* A1out, a ring of evicted pages */
+size_t twoq_ghost_max;			/* capacity of twoq_ghosts */
+size_t twoq_ghost_next;			/* slot for the next evicted page */
+struct list *twoq_buckets;		/* ghosts by hash of owner and address */
+size_t twoq_bucket_cnt;			/* number of twoq_buckets */
+
+static void
+twoq_init(void)
+{
+	size_t i;
+	list_init(&twoq_a1);
+	list_init(&twoq_am);
+	twoq_ghost_max = frame_cnt / 2 > 0 ? frame_cnt / 2 : 1;
+	twoq_ghosts = palloc_get_multiple(PAL_ASSERT | PAL_ZERO,
+		DIV_ROUND_UP(twoq_ghost_max * sizeof(struct twoq_ghost), PGSIZE));
+	twoq_bucket_cnt = twoq_ghost_max;
+	twoq_buckets = palloc_get_multiple(PAL_ASSERT,
+		DIV_ROUND_UP(twoq_bucket_cnt * sizeof(struct list), PGSIZE));
+	for(i = 0; i < twoq_bucket_cnt; i++)
+		list_init(&twoq_buckets[i]);
 }
 
-/*clockwise algorithm*/
-void
-clockwise_victim(void)
+/*bucket of the ghost of UPAGE of the thread TID*/
+static struct list *
+twoq_bucket(tid_t tid, void *upage)
 {
-	if(list_empty(&ft_list))
-		next_vict_elem = NULL;
-	else
+	return &twoq_buckets[hash_int((int)pg_no(upage) ^ tid) % twoq_bucket_cnt];
+}
+
+/*true if UPAGE of T was evicted from A1 recently, forgetting it*/
+static bool
+twoq_ghost_hit(struct thread *t, void *upage)
+{
+	struct list *b = twoq_bucket(t->tid, upage);
+	struct list_elem *e;
+	for(e = list_begin(b); e != list_end(b); e = list_next(e))
 	{
-		if(list_next(next_vict_elem) == list_end(&ft_list))
+		struct twoq_ghost *g = list_entry(e, struct twoq_ghost, elem);
+		if(g->upage == upage && g->tid == t->tid)
 		{
-			if(list_front(&ft_list) == next_vict_elem)
-				next_vict_elem = NULL;
-			else
-				next_vict_elem = list_front(&ft_list);
+			list_remove(&g->elem);
+			g->upage = NULL;
+			return true;
 		}
-		else
-			next_vict_elem = list_next(next_vict_elem);
 	}
+	return false;
 }
 
-/*select the victim using the second chance and clock algorithm*/
-struct frame *
-select_victim(void)
+/*remember UPAGE of the thread TID in place of the oldest ghost*/
+static void
+twoq_ghost_add(tid_t tid, void *upage)
 {
-	if(!list_empty(&ft_list))
-	  {
-	    struct frame *f;
-	    if(next_vict_elem == NULL)
-	      next_vict_elem = list_front(&ft_list);
-	    while(1)
-	      {
-		f = list_entry(next_vict_elem, struct frame, elem);
-		clockwise_victim();
-		if(pagedir_is_accessed(f->t->pagedir, f->page_addr))
-		  pagedir_set_accessed(f->t->pagedir, f->page_addr,false); //second chance algorithm + clock algorithm
-		else
-		  break;
-	      }
-	    return f;
-	  }
+	struct twoq_ghost *g = &twoq_ghosts[twoq_ghost_next];
+	if(g->upage != NULL)
+		list_remove(&g->elem);
+	g->tid = tid;
+	g->upage = upage;
+	list_push_back(twoq_bucket(tid, upage), &g->elem);
+	twoq_ghost_next = (twoq_ghost_next + 1) % twoq_ghost_max;
+}
+
+static void
+twoq_on_map(struct frame *f)
+{
+	f->hot = twoq_ghost_hit(f->t, f->page_addr);
+	if(f->hot)
+		list_push_back(&twoq_am, &f->policy_elem);
+	else
+	{
+		list_push_back(&twoq_a1, &f->policy_elem);
+		twoq_a1_cnt++;
+	}
+}
+
+/*an accessed Am frame goes to the back of the clock*/
+static void
+twoq_on_access_scan(struct frame *f, bool accessed)
+{
+	if(accessed && f->hot)
+	{
+		list_remove(&f->policy_elem);
+		list_push_back(&twoq_am, &f->policy_elem);
+	}
+}
+
+/*scan the queue Q for a victim.  An A1 frame goes as soon as it is
+  evictable, an Am frame gets a second chance if accessed.  Gives up
+  after two rounds of Q, when nothing in it can be evicted. */
+static struct frame *
+twoq_scan(struct list *q)
+{
+	size_t scan, len = list_size(q);
+	bool a1 = q == &twoq_a1;
+	for(scan = 0; scan < 2 * len; scan++)
+	{
+		struct frame *f = list_entry(list_front(q), struct frame, policy_elem);
+		/* move on past F, whatever happens to it */
+		list_remove(&f->policy_elem);
+		list_push_back(q, &f->policy_elem);
+		if(!evictable(f))
+			continue;
+		if(a1 || !scan_accessed(f))
+			return f;
+	}
 	return NULL;
 }
 
+/*take from A1 while it holds more than its share, else from Am.  If
+  every frame of that queue is pinned or in transit, try the other. */
+static struct frame *
+twoq_pick_victim(void)
+{
+	bool from_a1 = twoq_a1_cnt > frame_cnt / 4 || list_empty(&twoq_am);
+	struct frame *f = twoq_scan(from_a1 ? &twoq_a1 : &twoq_am);
+	if(f == NULL)
+		f = twoq_scan(from_a1 ? &twoq_am : &twoq_a1);
+	return f;
+}
+
+/*an A1 page evicted is remembered, so that a fault bringing it back
+  soon promotes it to Am*/
+static void
+twoq_on_evict(struct frame *f)
+{
+	if(!f->hot)
+		twoq_ghost_add(f->t->tid, f->page_addr);
+}
+
+static void
+twoq_on_free(struct frame *f)
+{
+	list_remove(&f->policy_elem);
+	if(!f->hot)
+		twoq_a1_cnt--;
+}
+
+/*select up to MAX victims, to be evicted in the same batch.  Stops
+  early when the policy has nothing new to offer.  Returns the number
+  selected. */
+static size_t
+select_victims(struct frame **victs, size_t max)
+{
+	size_t i, cnt = 0;
+	while(cnt < max)
+	{
+		struct frame *f = select_victim();
+		if(f == NULL)
+			break;
+		for(i = 0; i < cnt; i++)
+			if(victs[i] == f)
+				return cnt;
+		victs[cnt++] = f;
+	}
+	return cnt;
+}
+
 /*allocate the frame of which zero is true */
 void *
 frame_allocate(void *upage, bool mmapFlag, bool writable)
 {
-  frame_allocate_zeroflag(upage, mmapFlag, writable, true);
+  return frame_allocate_zeroflag(upage, mmapFlag, writable, true);
 }
 
 /*allocate the frame if get page succeed, then add new frame. 
@@ -106,185 +573,1101 @@ frame_allocate(void *upage, bool mmapFlag, bool writable)
 void *
 frame_allocate_zeroflag(void *upage, bool mmapFlag, bool writable, bool zero)
 {
-	void *kpage;
-	if(zero)
-		kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-	else
-		kpage = palloc_get_page (PAL_USER);
+	void *kpage = NULL;
+	/* a process at the hard cap replaces a frame of its own */
+	if(!rss_capped(thread_current(), 1))
+	{
+		if(zero)
+			kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+		else
+			kpage = palloc_get_page (PAL_USER);
+	}
 	if(kpage == NULL)
 	{
-	  kpage = replace_frame(upage, writable, zero);
+	  kpage = replace_frame(upage, mmapFlag, writable, zero);
 	}
 	else
 	{
 	  if(!add_new_frame(upage, kpage, mmapFlag, writable))
 	    kpage = NULL;
 	}
+	wake_cleaner();
 	return kpage;
 }
 
-/*add the new frame */
-bool
-add_new_frame(void *upage, void *kpage, bool mmapFlag, bool writable)
+/*allocate a frame only if one is free above the low watermark, never
+  evicting.  Used for read-ahead, which must not push out pages that
+  are in use. */
+void *
+frame_try_allocate(void *upage, bool mmapFlag, bool writable)
+{
+	void *kpage;
+	if(free_frames() <= frame_low_watermark || rss_capped(thread_current(), 1))
+		return NULL;
+	kpage = palloc_get_page (PAL_USER);
+	if(kpage != NULL && !add_new_frame(upage, kpage, mmapFlag, writable))
+		kpage = NULL;
+	return kpage;
+}
+
+/*record that the current thread maps UPAGE to the frame F */
+static void
+set_frame(struct frame *f, void *upage, bool mmapFlag, bool writable)
 {
-	ASSERT(find_frame(kpage) == NULL);
-	lock_acquire(&frame_lock);
-	struct frame *f = (struct frame *)malloc(sizeof(struct frame));
-	if(f == NULL)
-		return false;
 	f->page_addr = upage;
-	f->frame_addr = kpage;
 	f->t = thread_current();
 	f->writable = writable;
 	f->mmapFlag = mmapFlag;
+	f->ref_cnt = 1;
+	f->pin_cnt = 0;
+	f->large = false;
+	rss_charge(f->t, f);
 	
 	if (mmapFlag)
 	{
-		struct sup_page *sp = find_sp(&thread_current()->sp_table, upage);
-		f->ofs = sp->ofs;
-		f->read_bytes = sp->read_bytes;
-		f->zero_bytes = sp->zero_bytes;
-		f->fd = sp->fd;
-		f->file = sp->file;
+		struct vma *v = find_vma(thread_current(), upage);
+		f->ofs = vma_page_ofs(v, upage);
+		f->read_bytes = vma_page_read_bytes(v, upage);
+		f->zero_bytes = PGSIZE - f->read_bytes;
+		f->fd = v->fd;
+		f->file = v->file;
+		list_push_back(&v->frames, &f->vma_elem);
 	}
-	list_push_back(&ft_list, &f->elem);
+	policy->on_map(f);
+}
+
+/*add the new frame */
+bool
+add_new_frame(void *upage, void *kpage, bool mmapFlag, bool writable)
+{
+	size_t idx = frame_index(kpage);
+	ASSERT(idx != FRAME_NONE);
+	lock_acquire(&frame_lock);
+	struct frame *f = &frame_table[idx];
+	ASSERT(!f->in_use);
+	set_frame(f, upage, mmapFlag, writable);
+	f->in_use = true;
+	frame_used++;
 	lock_release(&frame_lock);
 	return true;
 }
 
-/* return replaced kernel virtual address */
+/*evict a batch of victims, leaving their frames in VICTS.  Must be
+  called with frame_lock held, which is released while the victims are
+  written out: they are unmapped and in transit by then, so no one else
+  picks them and a fault on their pages waits for the write.  Returns
+  the number of frames evicted. */
+static size_t
+evict_frames(struct frame **victs)
+{
+	struct sup_page *sps[SWAP_BATCH];
+	size_t i, cnt = select_victims(victs, SWAP_BATCH);
+	bool swapped;
+	if(cnt == 0 || !add_new_sp(victs, cnt, sps))
+		return 0;
+	for(i = 0; i < cnt; i++)
+		victs[i]->in_transit = true;
+	transit_cnt += cnt;
+	lock_release(&frame_lock);
+
+	swapped = write_sp(victs, sps, cnt);
+
+	lock_acquire(&frame_lock);
+	for(i = 0; i < cnt; i++)
+	{
+		victs[i]->in_transit = false;
+		cond_broadcast(&victs[i]->transit, &frame_lock);
+	}
+	transit_cnt -= cnt;
+	cond_broadcast(&transit_done, &frame_lock);
+	cnt = finish_sp(victs, sps, cnt, swapped);
+	for(i = 0; i < cnt; i++)
+		policy->on_evict(victs[i]);
+	evict_cnt += cnt;
+	return cnt;
+}
+
+/*first frame of T in transit, NULL if none*/
+static struct frame *
+transit_frame(struct thread *t)
+{
+	struct list_elem *e;
+	for(e = list_begin(&t->frame_list); e != list_end(&t->frame_list); e = list_next(e))
+	{
+		struct frame *f = list_entry(e, struct frame, thread_elem);
+		if(f->in_transit)
+			return f;
+	}
+	return NULL;
+}
+
+/*wait, with frame_lock held, until no frame of T is in transit.  Done
+  before walking the frames of T to unmap or share them. */
+static void
+wait_transit(struct thread *t)
+{
+	struct frame *f;
+	while((f = transit_frame(t)) != NULL)
+		cond_wait(&f->transit, &frame_lock);
+}
+
+/*wait until the page UPAGE of the current thread is no longer in
+  transit.  Returns its supplement page, NULL if it has none left. */
+struct sup_page *
+frame_wait_page(void *upage)
+{
+	struct thread *t = thread_current();
+	struct sup_page *sp;
+	lock_acquire(&frame_lock);
+	while((sp = find_sp(&t->sp_table, upage)) != NULL && sp->transit != NULL)
+	{
+		transit_wait_cnt++;
+		cond_wait(&sp->transit->transit, &frame_lock);
+	}
+	lock_release(&frame_lock);
+	return sp;
+}
+
+/*give the evicted frame F back to the user pool */
+static void
+release_frame(struct frame *f)
+{
+	unlink_frame(f);
+	f->in_use = false;
+	frame_used--;
+	palloc_free_page(f->frame_addr);
+}
+
+/* return replaced kernel virtual address.  The first victim is
+   reused for UPAGE, the rest of the batch go back to the user pool. */
 void *
-replace_frame(void *upage, bool writable, bool zero)
+replace_frame(void *upage, bool mmapFlag, bool writable, bool zero)
 {
+	struct frame *victs[SWAP_BATCH];
+	struct fault_time ft;
+	size_t i, cnt;
+	fault_begin(&ft);
 	lock_acquire(&frame_lock);
-	struct frame *vict = select_victim();
-	if(!add_new_sp(vict))
+	/* everything else may be in transit, then wait for a batch */
+	while((cnt = evict_frames(victs)) == 0 && transit_cnt > 0)
+		cond_wait(&transit_done, &frame_lock);
+	if(cnt == 0)
 	{
-		lock_release(&frame_lock);	
+		lock_release(&frame_lock);
+		fault_end(&ft, FAULT_EVICT);
 		return NULL;
 	}
-	if(vict->mmapFlag)
-		file_write_at (vict->file, vict->frame_addr, vict->read_bytes, vict->ofs);
-	vict->page_addr = upage;
-	vict->t = thread_current();
-	vict->writable = writable;
-	vict->mmapFlag = false;
+	for(i = 1; i < cnt; i++)
+		release_frame(victs[i]);
+	struct frame *vict = victs[0];
+	unlink_frame(vict);
+	set_frame(vict, upage, mmapFlag, writable);
 	if(zero)
 		memset(vict->frame_addr, 0, PGSIZE);
 	lock_release(&frame_lock);
+	fault_end(&ft, FAULT_EVICT);
 	return vict->frame_addr;
 }
 
+/*number of free frames in the user pool*/
+static size_t
+free_frames(void)
+{
+	return frame_cnt - frame_used;
+}
+
+/*page cleaner thread.  Whenever free frames drop below the low
+  watermark it evicts victims ahead of time, writing dirty ones back,
+  until the high watermark of free frames is reached again.  Faults
+  then find a free frame in the pool instead of evicting one. */
+static void
+frame_cleaner(void *aux UNUSED)
+{
+	struct frame *victs[SWAP_BATCH];
+	size_t i, cnt;
+	for(;;)
+	{
+		sema_down(&cleaner_sema);
+		cleaner_woken = false;
+		for(;;)
+		{
+			lock_acquire(&frame_lock);
+			cnt = free_frames() < frame_high_watermark ? evict_frames(victs) : 0;
+			for(i = 0; i < cnt; i++)
+				release_frame(victs[i]);
+			cleaned_cnt += cnt;
+			lock_release(&frame_lock);
+			if(cnt == 0)
+				break;
+		}
+	}
+}
+
+/*start the page cleaner thread.  Needs the swap disk. */
+void
+frame_cleaner_start(void)
+{
+	if(frame_high_watermark > frame_cnt / 2)
+		frame_high_watermark = frame_cnt / 2;
+	if(frame_low_watermark > frame_high_watermark)
+		frame_low_watermark = frame_high_watermark;
+	if(frame_low_watermark == 0)
+		return;
+	sema_init(&cleaner_sema, 0);
+	thread_create("pagecleaner", PRI_DEFAULT, frame_cleaner, NULL);
+}
+
+/*wake up the page cleaner if free frames are below the low watermark*/
+static void
+wake_cleaner(void)
+{
+	if(free_frames() < frame_low_watermark && !cleaner_woken)
+	{
+		cleaner_woken = true;
+		sema_up(&cleaner_sema);
+	}
+}
+
+/*print the statistics of the page cleaner */
+void
+frame_print_stats(void)
+{
+	printf("Frame: %zu of %zu frames in use, %lld pages cleaned ahead, %lld copied on write\n",
+		frame_used, frame_cnt, cleaned_cnt, cow_copy_cnt);
+	printf("Frame: %lld zero page mappings, %lld written, %lld large pages\n",
+		zero_map_cnt, zero_write_cnt, large_map_cnt);
+	printf("Frame: %s policy, %lld evictions, %lld waits for pages in transit\n",
+		policy->name, evict_cnt, transit_wait_cnt);
+	printf("Frame: %lld cold frames evicted, %lld mapped pages written back in %lld writes\n",
+		cold_evict_cnt, writeback_page_cnt, writeback_cnt);
+	printf("Frame: %zu frames largest resident set, %lld victims over allowance\n",
+		rss_peak, rss_victim_cnt);
+}
+
 /*delete the single frame */
 void
 delete_single_frame(void *kpage)
 {
 	//printf("delete_single_frame\n");
-	struct frame *f = find_frame(kpage);
 	lock_acquire(&frame_lock);
+	struct frame *f = find_frame(kpage);
 	if(f != NULL)
 	{
-		list_remove(&f->elem);	
-		free(f);
+		unlink_frame(f);
+		f->in_use = false;
+		frame_used--;
 		palloc_free_page(kpage);
 	}
 	lock_release(&frame_lock);
 }
 
-/* unmap, delete, and free the frames. Used in UNMAP system call. */
+/*take F off the frame list of its thread and of its mapping, and out
+  of the replacement policy*/
+static void
+unlink_frame(struct frame *f)
+{
+	if(!f->large)
+		policy->on_free(f);
+	if(f->cold)
+	{
+		list_remove(&f->cold_elem);
+		f->cold = false;
+	}
+	rss_uncharge(f);
+	if(f->mmapFlag)
+		list_remove(&f->vma_elem);
+}
+
+/*unmap and release the frame F, with frame_lock held.  A dirty memory
+  mapped frame is put on WRITEBACK instead of being freed, to be written
+  back to its file once the lock is released. */
+static void
+drop_frame(struct frame *f, struct list *writeback)
+{
+	bool dirty;
+	if(f->ref_cnt > 1)
+	{
+		/* still shared, hand it over to the first sharer */
+		struct frame_share *s = list_entry(list_pop_front(&f->sharers), struct frame_share, frame_elem);
+		pagedir_clear_page(f->t->pagedir, f->page_addr);
+		rss_uncharge(f);
+		list_remove(&s->thread_elem);
+		f->t = s->t;
+		f->ref_cnt--;
+		rss_charge(f->t, f);
+		free(s);
+		return;
+	}
+	unlink_frame(f);
+	dirty = pagedir_is_dirty(f->t->pagedir, f->page_addr);
+	pagedir_clear_page(f->t->pagedir, f->page_addr);
+	f->in_use = false;
+	frame_used -= frame_page_cnt(f);
+	if(f->mmapFlag && dirty)
+		list_push_back(writeback, &f->thread_elem);
+	else
+		palloc_free_multiple(f->frame_addr, frame_page_cnt(f));
+}
+
+/*order of the frames to write back, by file and offset*/
+static bool
+writeback_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	struct frame *fa = list_entry(a, struct frame, thread_elem);
+	struct frame *fb = list_entry(b, struct frame, thread_elem);
+	if(fa->file != fb->file)
+		return fa->file < fb->file;
+	return fa->ofs < fb->ofs;
+}
+
+/*true if the memory mapped page of B comes right after that of A in
+  the same file, so both are written back with one write*/
+static bool
+frame_follows(struct frame *a, struct frame *b)
+{
+	return !a->large && !b->large && a->file == b->file
+		&& a->read_bytes == PGSIZE && a->ofs + PGSIZE == b->ofs;
+}
+
+/*write the CNT memory mapped frames of RUN, each following the one
+  before, back to their file.  They are copied into BUFFER, of
+  WRITEBACK_BATCH pages, to be written at once; without a buffer they
+  are written one by one.  Called without frame_lock. */
+static void
+write_back_run(struct frame **run, size_t cnt, uint8_t *buffer)
+{
+	size_t i, len = 0;
+	if(buffer == NULL || cnt == 1)
+	{
+		for(i = 0; i < cnt; i++)
+			file_write_at(run[i]->file, run[i]->frame_addr, run[i]->read_bytes, run[i]->ofs);
+		writeback_cnt += cnt;
+	}
+	else
+	{
+		for(i = 0; i < cnt; i++)
+		{
+			memcpy(buffer + len, run[i]->frame_addr, run[i]->read_bytes);
+			len += run[i]->read_bytes;
+		}
+		file_write_at(run[0]->file, buffer, len, run[0]->ofs);
+		writeback_cnt++;
+	}
+	writeback_page_cnt += cnt;
+}
+
+/*write the frames on WRITEBACK to their files and free them, adjacent
+  pages of a file with one write.  Called without frame_lock: the
+  frames are no longer in use, but they are not given back to palloc
+  until written. */
+static void
+write_back_frames(struct list *writeback)
+{
+	struct frame *run[WRITEBACK_BATCH];
+	size_t i, cnt = 0;
+	uint8_t *buffer;
+	if(list_empty(writeback))
+		return;
+	buffer = palloc_get_multiple(0, WRITEBACK_BATCH);
+	list_sort(writeback, writeback_less, NULL);
+	while(!list_empty(writeback) || cnt > 0)
+	{
+		struct frame *f = NULL;
+		if(!list_empty(writeback))
+			f = list_entry(list_pop_front(writeback), struct frame, thread_elem);
+		if(cnt > 0 && (f == NULL || cnt == WRITEBACK_BATCH || !frame_follows(run[cnt - 1], f)))
+		{
+			write_back_run(run, cnt, buffer);
+			for(i = 0; i < cnt; i++)
+				palloc_free_multiple(run[i]->frame_addr, frame_page_cnt(run[i]));
+			cnt = 0;
+		}
+		if(f != NULL)
+			run[cnt++] = f;
+	}
+	if(buffer != NULL)
+		palloc_free_multiple(buffer, WRITEBACK_BATCH);
+}
+
+/*write the dirty pages of memory mapped files of the current thread
+  from START to END back to their files, clearing their dirty bits.
+  The pages stay mapped, pinned while they are written. */
 void
-unmap_frames(int fd)
+frame_msync(void *start, void *end)
 {
-	struct list_elem *e1;
-	struct list_elem *e2;
-	struct frame *f;
-	lock_acquire(&frame_lock);
-	if (!list_empty(&ft_list))
+	struct thread *t = thread_current();
+	struct frame *run[WRITEBACK_BATCH];
+	uint8_t *buffer = palloc_get_multiple(0, WRITEBACK_BATCH);
+	uint8_t *upage = start;
+	size_t i, cnt;
+	do
 	{
-		e1 = list_begin(&ft_list);
-		while (e1 != list_end(&ft_list))
+		lock_acquire(&frame_lock);
+		/* pages being evicted reach the file first */
+		wait_transit(t);
+		for(cnt = 0; upage < (uint8_t *)end && cnt < WRITEBACK_BATCH; upage += PGSIZE)
 		{
-			f = list_entry(e1, struct frame, elem);
-			if ((f->fd == fd) && (f->mmapFlag))
+			struct frame *f = frame_holding(pagedir_get_page(t->pagedir, upage));
+			if(f == NULL || !f->mmapFlag || f->t != t
+			   || !pagedir_is_dirty(t->pagedir, upage))
 			{
-				file_write_at(f->file, f->frame_addr, f->read_bytes, f->ofs);
-				e2 = list_next(e1);
-				if (e1 == next_vict_elem)
-					clockwise_victim();
-				list_remove(e1);
-				e1 = e2;
-				pagedir_clear_page(f->t->pagedir, f->page_addr);
-				palloc_free_page(f->frame_addr);
-				free(f);
-			} 
-			else
-				e1 = list_next(e1);
+				if(cnt > 0)
+					break;
+				continue;
+			}
+			if(cnt > 0 && !frame_follows(run[cnt - 1], f))
+				break;
+			pagedir_set_dirty(t->pagedir, upage, false);
+			f->pin_cnt++;
+			run[cnt++] = f;
+			if(f->large)
+				upage = (uint8_t *)f->page_addr + PTSPAN - PGSIZE;
 		}
+		lock_release(&frame_lock);
+		if(cnt == 0)
+			break;
+		write_back_run(run, cnt, buffer);
+		lock_acquire(&frame_lock);
+		for(i = 0; i < cnt; i++)
+			run[i]->pin_cnt--;
+		lock_release(&frame_lock);
+	}
+	while(upage < (uint8_t *)end);
+	if(buffer != NULL)
+		palloc_free_multiple(buffer, WRITEBACK_BATCH);
+}
+
+/*unmap the resident pages of the memory mapped file FD of the current
+  thread, writing them back to the file */
+void
+unmap_frames(int fd)
+{
+	struct thread *t = thread_current();
+	struct list writeback;
+	struct list_elem *e;
+	list_init(&writeback);
+	lock_acquire(&frame_lock);
+	wait_transit(t);
+	for(e = list_begin(&t->vma_list); e != list_end(&t->vma_list); e = list_next(e))
+	{
+		struct vma *v = list_entry(e, struct vma, elem);
+		if(!v->mmapFlag || v->fd != fd)
+			continue;
+		while(!list_empty(&v->frames))
+			drop_frame(list_entry(list_front(&v->frames), struct frame, vma_elem), &writeback);
 	}
 	lock_release(&frame_lock);
+	write_back_frames(&writeback);
 }
 
 /*delete the all the thread frame. */
-void *
+void
 remove_thread_frame(struct thread *t)
 {
-	struct list_elem *e1;
-	struct list_elem *e2;
+	struct list writeback;
+	list_init(&writeback);
+	lock_acquire(&frame_lock);
+	wait_transit(t);
+	while(!list_empty(&t->shared_list))
+		drop_share(list_entry(list_front(&t->shared_list), struct frame_share, thread_elem));
+	while(!list_empty(&t->frame_list))
+		drop_frame(list_entry(list_front(&t->frame_list), struct frame, thread_elem), &writeback);
+	lock_release(&frame_lock);
+	write_back_frames(&writeback);
+}
+
+/*unmap the shared frame of S from its process and free S*/
+static void
+drop_share(struct frame_share *s)
+{
+	pagedir_clear_page(s->t->pagedir, s->f->page_addr);
+	list_remove(&s->frame_elem);
+	list_remove(&s->thread_elem);
+	s->f->ref_cnt--;
+	free(s);
+}
+
+/*the share of T in the shared frame F*/
+static struct frame_share *
+find_share(struct frame *f, struct thread *t)
+{
+	struct list_elem *e;
+	for(e = list_begin(&f->sharers); e != list_end(&f->sharers); e = list_next(e))
+		if(list_entry(e, struct frame_share, frame_elem)->t == t)
+			break;
+	ASSERT(e != list_end(&f->sharers));
+	return list_entry(e, struct frame_share, frame_elem);
+}
+
+/*map the frame F of PARENT, or shared by PARENT, into the current
+  thread at the same address.  Writable pages become read-only in both
+  processes, keeping their dirty bit, until one of them writes. */
+static bool
+share_frame(struct frame *f, struct thread *parent)
+{
+	struct thread *t = thread_current();
+	struct frame_share *s = (struct frame_share *)malloc(sizeof(struct frame_share));
+	if(s == NULL)
+		return false;
+	if(!pagedir_set_page(t->pagedir, f->page_addr, f->frame_addr, false))
+	{
+		free(s);
+		return false;
+	}
+	if(pagedir_is_dirty(parent->pagedir, f->page_addr))
+		pagedir_set_dirty(t->pagedir, f->page_addr, true);
+	if(f->writable)
+		pagedir_set_writable(parent->pagedir, f->page_addr, false);
+	s->t = t;
+	s->f = f;
+	list_push_back(&f->sharers, &s->frame_elem);
+	list_push_back(&t->shared_list, &s->thread_elem);
+	f->ref_cnt++;
+	return true;
+}
+
+/*share the resident pages of PARENT with the current thread, its
+  child being forked.  Memory mapped pages are not inherited, and
+  large pages are copied. */
+bool
+frame_fork(struct thread *parent)
+{
+	struct list_elem *e;
+	bool success = true;
+	lock_acquire(&frame_lock);
+	wait_transit(parent);
+	for(e = list_begin(&parent->frame_list); success && e != list_end(&parent->frame_list); e = list_next(e))
+	{
+		struct frame *f = list_entry(e, struct frame, thread_elem);
+		if(f->large && !f->mmapFlag)
+			success = copy_large_frame(f);
+		else if(!f->mmapFlag)
+			success = share_frame(f, parent);
+	}
+	for(e = list_begin(&parent->shared_list); success && e != list_end(&parent->shared_list); e = list_next(e))
+		success = share_frame(list_entry(e, struct frame_share, thread_elem)->f, parent);
+	lock_release(&frame_lock);
+	return success;
+}
+
+/*map the zero page at UPAGE of the current thread, on a read fault of
+  a page that starts out zero*/
+bool
+frame_map_zero(void *upage)
+{
+	if(!pagedir_set_shared_page(thread_current()->pagedir, upage, zero_page))
+		return false;
+	zero_map_cnt++;
+	return true;
+}
+
+/*give UPAGE of the current thread, mapped to the zero page, a zeroed
+  frame of its own on the first write*/
+static bool
+write_zero_page(void *upage)
+{
+	struct thread *t = thread_current();
+	struct vma *v = find_vma(t, upage);
+	void *kpage;
+	/* zero pages outside any region are stack pages */
+	if(v != NULL && !v->writable)
+		return false;
+	kpage = frame_allocate(upage, false, true);
+	if(kpage == NULL)
+		return false;
+	pagedir_clear_page(t->pagedir, upage);
+	if(!pagedir_set_page(t->pagedir, upage, kpage, true))
+	{
+		delete_single_frame(kpage);
+		return false;
+	}
+	zero_write_cnt++;
+	return true;
+}
+
+/*handle a write fault on UPAGE of the current thread that may be a
+  copy-on-write page.  A frame no longer shared is made writable again,
+  otherwise the thread gets its own copy.  False if UPAGE is not a
+  writable user page in a frame. */
+bool
+frame_cow_fault(void *upage)
+{
+	struct thread *t = thread_current();
 	struct frame *f;
+	void *kpage, *copy;
+	/*a write to kernel memory is left to the kill path*/
+	if(!is_user_vaddr(upage))
+		return false;
+	kpage = pagedir_get_page(t->pagedir, upage);
+	if(kpage != NULL && kpage == zero_page)
+		return write_zero_page(upage);
 	lock_acquire(&frame_lock);
-	if(!list_empty(&ft_list))
+	f = kpage != NULL ? find_frame(kpage) : NULL;
+	if(f == NULL || !f->writable)
 	{
-		e1 = list_front(&ft_list);
-		while(e1!=list_end(&ft_list))
+		lock_release(&frame_lock);
+		return false;
+	}
+	if(f->ref_cnt == 1)
+	{
+		pagedir_set_writable(t->pagedir, upage, true);
+		lock_release(&frame_lock);
+		return true;
+	}
+	lock_release(&frame_lock);
+
+	/* allocating may evict, so it is done without the lock */
+	copy = frame_allocate_zeroflag(upage, false, true, false);
+	if(copy == NULL)
+		return false;
+	lock_acquire(&frame_lock);
+	if(f->ref_cnt == 1 || pagedir_get_page(t->pagedir, upage) != kpage)
+	{
+		/* the other processes let go of the frame meanwhile */
+		lock_release(&frame_lock);
+		delete_single_frame(copy);
+		return true;
+	}
+	memcpy(copy, kpage, PGSIZE);
+	if(f->t == t)
+		drop_frame(f, NULL);
+	else
+		drop_share(find_share(f, t));
+	pagedir_set_page(t->pagedir, upage, copy, true);
+	pagedir_set_dirty(t->pagedir, upage, true);
+	cow_copy_cnt++;
+	lock_release(&frame_lock);
+	return true;
+}
+
+/*If page fault, in specific situation, grow the stack.  Only the
+  faulting page is brought in: the pages above it are left to fault on
+  their own, a read mapping the zero page and a WRITE a new frame.*/
+bool
+stack_growth(void *fault_addr, struct intr_frame *f, bool write)
+{
+	return grow_stack(fault_addr, f->esp, write);
+}
+
+/*grow the stack at FAULT_ADDR if it is in reach of the user stack
+  pointer ESP*/
+static bool
+grow_stack(void *fault_addr, void *esp, bool write)
+{
+	void *kpage;
+	struct thread *curr = thread_current();
+	void *upage = pg_round_down(fault_addr);
+	if ((fault_addr >= curr->stack_lim || fault_addr >= (esp - 32))
+	    && (fault_addr >= (PHYS_BASE-(1<<23))) && is_user_vaddr(fault_addr))
+	{
+		if (upage < curr->stack_lim)
+			curr->stack_lim = upage;
+		if (pagedir_get_page (curr->pagedir, upage) != NULL)
+			return false;
+		if (!write)
+			return frame_map_zero(upage);
+		kpage = frame_allocate(upage, false,true);
+		if(kpage == NULL) 
+			return false;
+		if (!pagedir_set_page (curr->pagedir, upage, kpage, true))
 		{
-			f = list_entry(e1, struct frame, elem);
-			if(f->t->tid == t->tid)
+			delete_single_frame(kpage);
+			return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+/*pin UPAGE of the current thread if it is mapped, and writable if
+  WRITABLE.  The zero page is never evicted and needs no pin. */
+static bool
+pin_page(void *upage, bool writable)
+{
+	struct thread *t = thread_current();
+	void *kpage;
+	struct frame *f;
+	bool pinned = false;
+	lock_acquire(&frame_lock);
+	kpage = pagedir_get_page(t->pagedir, upage);
+	if(kpage != NULL && (!writable || pagedir_is_writable(t->pagedir, upage)))
+	{
+		f = frame_holding(kpage);
+		if(f != NULL)
+			f->pin_cnt++;
+		pinned = f != NULL || kpage == zero_page;
+	}
+	lock_release(&frame_lock);
+	return pinned;
+}
+
+/*bring in the page at ADDR of the current thread as a fault on it
+  would, a WRITABLE one if asked*/
+static bool
+fault_in_page(void *addr, bool writable)
+{
+	struct thread *t = thread_current();
+	void *upage = pg_round_down(addr);
+	enum fault_class cls;
+	if(pagedir_get_page(t->pagedir, upage) != NULL)
+		return writable && frame_cow_fault(upage);
+	return load_page(upage, writable, &cls) || grow_stack(addr, t->user_esp, writable);
+}
+
+/*fault in and pin every page of the user buffer UADDR of LEN bytes,
+  so that a system call can copy it with no page fault, in particular
+  none while it holds a filesystem lock.  WRITABLE asks for pages the
+  call may write.  False, with nothing left pinned, if part of the
+  buffer is not valid user memory. */
+bool
+pin_user_range(const void *uaddr, size_t len, bool writable)
+{
+	uint8_t *start = (uint8_t *)uaddr;
+	uint8_t *end = start + len;
+	uint8_t *upage;
+	if(len == 0)
+		return true;
+	if(end < start || end > (uint8_t *)PHYS_BASE)
+		return false;
+	for(upage = pg_round_down(start); upage < end; upage += PGSIZE)
+	{
+		/* an eviction may take the page again before it is pinned */
+		while(!pin_page(upage, writable))
+			if(!fault_in_page(upage < start ? start : upage, writable))
 			{
-				if (f->mmapFlag)
-				{
-					file_write_at (f->file, f->frame_addr, f->read_bytes, f->ofs);
-				}
-				e2 = list_next(e1);
-				if(e1 == next_vict_elem)
-					clockwise_victim();
-				list_remove(e1);
-				e1 = e2;
-				pagedir_clear_page(t->pagedir, f->page_addr);
-				palloc_free_page(f->frame_addr);
-				free(f);
+				if(upage > start)
+					unpin_user_range(start, upage - start);
+				return false;
 			}
-			else
-				e1 = list_next(e1);
+	}
+	return true;
+}
+
+/*undo pin_user_range() of the user buffer UADDR of LEN bytes*/
+void
+unpin_user_range(const void *uaddr, size_t len)
+{
+	struct thread *t = thread_current();
+	uint8_t *start = (uint8_t *)uaddr;
+	uint8_t *upage;
+	lock_acquire(&frame_lock);
+	for(upage = pg_round_down(start); upage < start + len; upage += PGSIZE)
+	{
+		struct frame *f = frame_holding(pagedir_get_page(t->pagedir, upage));
+		if(f != NULL && f->pin_cnt > 0)
+			f->pin_cnt--;
+	}
+	lock_release(&frame_lock);
+}
+
+/*let the resident pages of the current thread from START to END be
+  evicted first, with their accessed bits cleared.  A page accessed
+  again before it is picked is left to the policy. */
+void
+frame_mark_cold(void *start, void *end)
+{
+	struct thread *t = thread_current();
+	uint8_t *upage;
+	lock_acquire(&frame_lock);
+	for(upage = start; upage < (uint8_t *)end; upage += PGSIZE)
+	{
+		struct frame *f = find_frame(pagedir_get_page(t->pagedir, upage));
+		if(f == NULL || f->t != t || f->large || f->cold)
+			continue;
+		pagedir_set_accessed(t->pagedir, upage, false);
+		list_push_back(&cold_list, &f->cold_elem);
+		f->cold = true;
+	}
+	lock_release(&frame_lock);
+}
+
+/*unmap the resident pages of the current thread from START to END.
+  Memory mapped pages are written back to their file; the others are
+  dropped, to be read again from their region or zero filled on the
+  next fault.  Large and pinned pages are kept.  Returns the number of
+  pages unmapped, the zero page aside. */
+size_t
+frame_discard(void *start, void *end)
+{
+	struct thread *t = thread_current();
+	struct list writeback;
+	uint8_t *upage;
+	size_t cnt = 0;
+	list_init(&writeback);
+	lock_acquire(&frame_lock);
+	wait_transit(t);
+	for(upage = start; upage < (uint8_t *)end; upage += PGSIZE)
+	{
+		void *kpage = pagedir_get_page(t->pagedir, upage);
+		struct frame *f;
+		if(kpage == NULL)
+			continue;
+		if(kpage == zero_page)
+		{
+			pagedir_clear_page(t->pagedir, upage);
+			continue;
 		}
+		f = frame_holding(kpage);
+		if(f == NULL || f->large || f->pin_cnt > 0)
+			continue;
+		if(f->t == t)
+			drop_frame(f, &writeback);
+		else
+			drop_share(find_share(f, t));
+		cnt++;
 	}
 	lock_release(&frame_lock);
+	write_back_frames(&writeback);
+	return cnt;
 }
 
-/*If page fault, in specific situation, grow the stack.*/
+/*true if T has more frames than its allowance*/
+static bool
+rss_over(struct thread *t)
+{
+	return t->rss > t->rss_allowance;
+}
+
+/*true if CNT more frames would take T over the hard cap*/
+static bool
+rss_capped(struct thread *t, size_t cnt)
+{
+	return frame_rss_max != 0 && t->rss + cnt > frame_rss_max;
+}
+
+/*put the frame F on the frame list of T, counting it in the resident
+  set, with frame_lock held*/
+static void
+rss_charge(struct thread *t, struct frame *f)
+{
+	bool over = rss_over(t);
+	list_push_back(&t->frame_list, &f->thread_elem);
+	t->rss += frame_page_cnt(f);
+	if(t->rss > t->rss_peak)
+		t->rss_peak = t->rss;
+	if(t->rss > rss_peak)
+		rss_peak = t->rss;
+	if(!over && rss_over(t))
+		rss_over_cnt++;
+}
+
+/*take the frame F off the frame list of its thread, with frame_lock
+  held*/
+static void
+rss_uncharge(struct frame *f)
+{
+	struct thread *t = f->t;
+	bool over = rss_over(t);
+	list_remove(&f->thread_elem);
+	t->rss -= frame_page_cnt(f);
+	if(over && !rss_over(t))
+		rss_over_cnt--;
+}
+
+/*set the allowance of T, with frame_lock held*/
+static void
+rss_set_allowance(struct thread *t, size_t allowance)
+{
+	bool over = rss_over(t);
+	t->rss_allowance = allowance;
+	if(over && !rss_over(t))
+		rss_over_cnt--;
+	else if(!over && rss_over(t))
+		rss_over_cnt++;
+}
+
+/*pick a victim among the frames of ONLY, or of any process over its
+  allowance if ONLY is null, with a second chance clock of its own over
+  the frame table.  NULL if two turns find none. */
+static struct frame *
+rss_pick_victim(struct thread *only)
+{
+	size_t scan;
+	for(scan = 0; scan <= 2 * frame_cnt; scan++)
+	{
+		struct frame *f = &frame_table[rss_hand];
+		if(++rss_hand >= frame_cnt)
+			rss_hand = 0;
+		if(!evictable(f) || (only != NULL ? f->t != only : !rss_over(f->t)))
+			continue;
+		if(!scan_accessed(f))
+		{
+			rss_victim_cnt++;
+			return f;
+		}
+	}
+	return NULL;
+}
+
+/*start the resident set of T, a new process, at the least allowance*/
+void
+frame_rss_init(struct thread *t)
+{
+	t->rss_allowance = RSS_MIN;
+	t->pff_last = timer_ticks();
+}
+
+/*page fault frequency controller, run on every page fault of the
+  current thread.  The allowance stays within the least one, the hard
+  cap and the frame table. */
+void
+frame_pff_fault(void)
+{
+	struct thread *t = thread_current();
+	int64_t now = timer_ticks();
+	size_t allowance = t->rss_allowance;
+	if(t->pagedir == NULL)
+		return;
+	if(now - t->pff_last < PFF_LOW)
+		allowance += PFF_GROW;
+	else if(now - t->pff_last > PFF_HIGH)
+		allowance -= allowance / 4;
+	if(frame_rss_max != 0 && allowance > frame_rss_max)
+		allowance = frame_rss_max;
+	if(allowance > frame_cnt)
+		allowance = frame_cnt;
+	if(allowance < RSS_MIN)
+		allowance = RSS_MIN;
+	t->pff_last = now;
+	if(allowance != t->rss_allowance)
+	{
+		lock_acquire(&frame_lock);
+		rss_set_allowance(t, allowance);
+		lock_release(&frame_lock);
+	}
+}
+
+/*store the resident set of the current thread in ST*/
+void
+frame_get_rss(struct rss_stat *st)
+{
+	struct thread *t = thread_current();
+	lock_acquire(&frame_lock);
+	st->rss = t->rss;
+	st->peak = t->rss_peak;
+	st->allowance = t->rss_allowance;
+	st->max = frame_rss_max;
+	lock_release(&frame_lock);
+}
+
+/*number of pages of the frame F*/
+static size_t
+frame_page_cnt(struct frame *f)
+{
+	return f->large ? LARGE_PAGE_CNT : 1;
+}
+
+/*frame holding the kernel page KPAGE, the first frame of the large
+  page for any page of one.  NULL if none. */
+static struct frame *
+frame_holding(void *kpage)
+{
+	struct frame *f = find_frame(kpage);
+	if(f == NULL && kpage != NULL)
+	{
+		f = find_frame((void *)((uintptr_t)kpage & ~(uintptr_t)(PTSPAN - 1)));
+		if(f != NULL && !f->large)
+			f = NULL;
+	}
+	return f;
+}
+
+/*map BLOCK of the current thread to the large page KPAGE, with
+  frame_lock held.  Returns its frame, NULL if BLOCK has pages mapped
+  already. */
+static struct frame *
+add_large_frame(void *kpage, void *block, bool writable)
+{
+	struct thread *t = thread_current();
+	struct frame *f = &frame_table[frame_index(kpage)];
+	if(!pagedir_set_large_page(t->pagedir, block, kpage, writable))
+		return NULL;
+	f->t = t;
+	f->page_addr = block;
+	f->writable = writable;
+	f->mmapFlag = false;
+	f->ref_cnt = 1;
+	f->pin_cnt = 0;
+	f->large = true;
+	f->in_use = true;
+	rss_charge(t, f);
+	frame_used += LARGE_PAGE_CNT;
+	return f;
+}
+
+/*map the 4 MB block holding UPAGE of the region V of the current
+  thread with one large page.  Only with -vm-large, when V covers the
+  whole block, none of it was brought in yet, and an aligned run of
+  free frames is found; otherwise false, and the fault is served
+  with 4 kB pages. */
 bool
-stack_growth(void *fault_addr, struct intr_frame *f)
+frame_map_large(struct vma *v, void *upage)
 {
-	void *kpage;
-	struct thread *curr = thread_current();
-	if ((fault_addr <= curr->stack_lim) && (fault_addr >= (f->esp - 32)) && (fault_addr >= (PHYS_BASE-(1<<23))))
-	{
-    	while (pg_round_down(fault_addr) < curr->stack_lim){
-      		curr->stack_lim = (((uint8_t *) curr->stack_lim) - PGSIZE);
-      		kpage = frame_allocate(curr->stack_lim, false,true);
-      		if(kpage == NULL) 
-      		{
-      			delete_single_frame(kpage);
-      			return false;
-      		}
-      		bool install = (pagedir_get_page (curr->pagedir, curr->stack_lim) == NULL
-      			&& pagedir_set_page (curr->pagedir, curr->stack_lim, kpage, true));
-      		if (!install)
-      		{
-        		delete_single_frame(kpage);
-        		return false;
-      		}
-    	}
-    	return true;
-    }
-    return false;
+	struct thread *t = thread_current();
+	uint8_t *block = (uint8_t *)((uintptr_t)upage & ~(uintptr_t)(PTSPAN - 1));
+	uint8_t *page, *kpage;
+	uint32_t read_bytes = 0;
+	struct frame *f;
+	if(!frame_large_pages || !paging_pse || block < v->start || block + PTSPAN > v->end
+	   || rss_capped(t, LARGE_PAGE_CNT))
+		return false;
+	for(page = block; page < block + PTSPAN; page += PGSIZE)
+		if(pagedir_get_page(t->pagedir, page) != NULL || find_sp(&t->sp_table, page) != NULL)
+			return false;
+	kpage = palloc_get_aligned(PAL_USER, LARGE_PAGE_CNT, LARGE_PAGE_CNT);
+	if(kpage == NULL)
+		return false;
+	if(v->start + v->read_bytes > block)
+	{
+		read_bytes = v->start + v->read_bytes - block;
+		if(read_bytes > PTSPAN)
+			read_bytes = PTSPAN;
+	}
+	if(file_read_at(v->file, kpage, read_bytes, v->ofs + (block - v->start)) != (off_t)read_bytes)
+	{
+		palloc_free_multiple(kpage, LARGE_PAGE_CNT);
+		return false;
+	}
+	memset(kpage + read_bytes, 0, PTSPAN - read_bytes);
+
+	lock_acquire(&frame_lock);
+	f = add_large_frame(kpage, block, v->writable);
+	if(f == NULL)
+	{
+		lock_release(&frame_lock);
+		palloc_free_multiple(kpage, LARGE_PAGE_CNT);
+		return false;
+	}
+	if(v->mmapFlag)
+	{
+		f->mmapFlag = true;
+		f->ofs = vma_page_ofs(v, block);
+		f->read_bytes = read_bytes;
+		f->zero_bytes = PTSPAN - read_bytes;
+		f->fd = v->fd;
+		f->file = v->file;
+		list_push_back(&v->frames, &f->vma_elem);
+	}
+	large_map_cnt++;
+	lock_release(&frame_lock);
+	return true;
+}
+
+/*give the current thread, a child being forked, a copy of the large
+  page F of its parent.  Called with frame_lock held.  Fails if no
+  aligned run of free frames is left. */
+static bool
+copy_large_frame(struct frame *f)
+{
+	void *kpage = palloc_get_aligned(PAL_USER, LARGE_PAGE_CNT, LARGE_PAGE_CNT);
+	if(kpage == NULL)
+		return false;
+	memcpy(kpage, f->frame_addr, PTSPAN);
+	if(add_large_frame(kpage, f->page_addr, f->writable) == NULL)
+	{
+		palloc_free_multiple(kpage, LARGE_PAGE_CNT);
+		return false;
+	}
+	large_map_cnt++;
+	return true;
 }
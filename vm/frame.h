@@ -1,11 +1,24 @@
 #ifndef VM_FRAME_H
 #define VM_FRAME_H
 #include "threads/thread.h"
+#include "threads/synch.h"
 #include <list.h>
 
+struct intr_frame;
+struct sup_page;
+struct vma;
+struct rss_stat;
+
+/* Lock order: frame_lock, then the sp_lock of a thread.  Eviction
+   takes the victim's sp_lock with frame_lock held, so no one may
+   allocate a frame, or wait on anything that does, while holding an
+   sp_lock.  File and swap I/O for a page being loaded is done
+   without it. */
+
 struct frame *find_frame(void *frame_addr);
 struct frame *select_victim(void);
-/* Struct frame. Elements of frame table by using list structure. */
+/* Struct frame. Elements of frame table, one per user pool page,
+   indexed by physical frame number. */
 
 
 struct frame{
@@ -15,7 +28,28 @@ struct frame{
   bool writable;			/* frame writable or not */
   
   bool mmapFlag;			/* frame memory-mapped or not*/
-  struct list_elem elem;		
+  bool in_use;				/* frame holds a user page or not */
+  bool in_transit;			/* being written out by an eviction, the
+					   page is unmapped and the frame pinned */
+  size_t pin_cnt;			/* system calls using the page, never
+					   evicted while nonzero */
+  bool large;				/* first frame of a 4 MB page, never
+					   evicted; the others are not used on
+					   their own */
+  struct condition transit;		/* signaled when in_transit is cleared */
+  struct list_elem thread_elem;		/* element of the owner's frame_list */
+  struct list_elem vma_elem;		/* element of the mapping's frames */
+  size_t ref_cnt;			/* processes mapping the frame, more than
+					   one while shared copy-on-write */
+  struct list sharers;			/* frame_share of the processes other than t */
+
+  /* owned by the replacement policy */
+  struct list_elem policy_elem;		/* element of the policy's queues */
+  int64_t last_use;			/* ticks when last seen accessed */
+  bool hot;				/* referenced again after eviction */
+
+  bool cold;				/* on cold_list */
+  struct list_elem cold_elem;		/* element of cold_list */
 
   int fd;				/* file descriptor, also used as mapID of mmaped files */
   struct file *file;			 
@@ -24,18 +58,54 @@ struct frame{
   uint32_t zero_bytes;			/* zero_bytes for mmaped frames */
 };
 
+/* A process other than the owner mapping a shared frame, after
+   fork().  The page is read-only in every process until written. */
+struct frame_share{
+  struct thread *t;			/* sharing thread */
+  struct frame *f;			/* shared frame */
+  struct list_elem frame_elem;		/* element of the frame's sharers */
+  struct list_elem thread_elem;		/* element of the thread's shared_list */
+};
+
+/* Free frame watermarks of the page cleaner. */
+extern size_t frame_low_watermark;
+extern size_t frame_high_watermark;
+
+/* Map large aligned regions with 4 MB pages, -vm-large. */
+extern bool frame_large_pages;
+
+/* Hard cap on the frames of a process, -vm-rss, 0 for none. */
+extern size_t frame_rss_max;
+
 void frame_init(void);
+bool frame_set_policy(const char *name);
+void frame_cleaner_start(void);
+void frame_print_stats(void);
 struct frame *find_frame (void *);
 void clockwise_victim (void);
 struct frame *select_victim (void);
 void *frame_allocate(void *upage,bool mmapFlag, bool writable);
 void *frame_allocate_zeroflag(void *upage, bool mmapFlag, bool writable, bool zero);
+void *frame_try_allocate(void *upage, bool mmapFlag, bool writable);
 bool add_new_frame(void *upage, void *kpage, bool mmapFlag, bool writable);
-void *replace_frame(void *upage, bool writable, bool zero);
+void *replace_frame(void *upage, bool mmapFlag, bool writable, bool zero);
 void unmap_frames (int);
 
 void delete_single_frame(void *kpage);
-void *remove_thread_frame(struct thread *t);
-bool stack_growth (void *, struct intr_frame *);
+void remove_thread_frame(struct thread *t);
+bool stack_growth (void *, struct intr_frame *, bool write);
+bool frame_map_zero (void *upage);
+bool frame_map_large (struct vma *v, void *upage);
+bool frame_fork (struct thread *parent);
+bool frame_cow_fault (void *upage);
+struct sup_page *frame_wait_page (void *upage);
+bool pin_user_range (const void *uaddr, size_t len, bool writable);
+void unpin_user_range (const void *uaddr, size_t len);
+void frame_mark_cold (void *start, void *end);
+size_t frame_discard (void *start, void *end);
+void frame_msync (void *start, void *end);
+void frame_rss_init (struct thread *t);
+void frame_pff_fault (void);
+void frame_get_rss (struct rss_stat *st);
 
 #endif /* vm/frame.h */
@@ -1,6 +1,7 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/vma.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
 #include "threads/thread.h"
@@ -14,112 +15,326 @@
 #include <stdio.h>
 #include <list.h>
 
+/* Read-ahead window of faults on file backed pages, in pages. */
+#define RA_WINDOW_MIN 1
+#define RA_WINDOW_MAX 16
+
+long long exe_fault_cnt;		/* faults on file backed pages */
+long long ra_page_cnt;			/* pages mapped by read-ahead */
+long long ra_hit_cnt;			/* read-ahead pages then touched */
+long long prefetch_cnt;			/* pages brought in by MADV_WILLNEED */
+long long discard_cnt;			/* pages dropped by MADV_DONTNEED */
+
+static unsigned sp_hash(const struct hash_elem *e, void *aux UNUSED);
+static bool sp_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED);
+static void sp_destroy(struct hash_elem *e, void *aux UNUSED);
+static bool map_exefile(struct vma *v, void *upage, void *kpage);
+static size_t count_ra_hits(struct thread *t);
+static void adapt_ra_window(struct thread *t, struct vma *v, void *upage);
+static void read_ahead(struct vma *v, void *upage);
+static void drop_behind(struct vma *v, void *upage);
+static void drop_random(struct vma *v, void *upage);
+static bool map_swap(struct sup_page *sp, void *kpage);
+static bool prefetch_page(void *upage);
+static void discard_pages(uint8_t *start, uint8_t *end);
+static bool user_range(void *addr, size_t len, uint8_t **end);
+
+/*hash function of the supplement table, keyed on the virtual address*/
+static unsigned
+sp_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct sup_page *sp = hash_entry(e, struct sup_page, elem);
+	return hash_int((int)pg_no(sp->upage));
+}
+
+/*order of the supplement pages, by the virtual address*/
+static bool
+sp_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	const struct sup_page *sp_a = hash_entry(a, struct sup_page, elem);
+	const struct sup_page *sp_b = hash_entry(b, struct sup_page, elem);
+	return sp_a->upage < sp_b->upage;
+}
+
+/*initialize the supplement table of the thread, and its resident set*/
+bool
+init_spt(struct thread *t)
+{
+	frame_rss_init(t);
+	return hash_init(&t->sp_table, sp_hash, sp_less, NULL);
+}
+
 /*using supplement table, find the supplement page*/
 struct sup_page *
-find_sp(struct list *sp_table, void *upage)
+find_sp(struct hash *sp_table, void *upage)
 {
-	struct list_elem *e;
-	struct sup_page *sp;
+	struct sup_page key;
+	struct hash_elem *e;
+	key.upage = upage;
 	lock_acquire(&thread_current()->sp_lock);
-	if(!list_empty(sp_table))
-	{
-		e = list_front(sp_table); 
-		while(e!=list_end(sp_table))
-		{
-			sp = list_entry(e, struct sup_page, elem);
-			if(sp->upage == upage)
-			{
-				lock_release(&thread_current()->sp_lock);
-				return sp;
-			}
-			e = list_next(e);
-		}
-	}
+	e = hash_find(sp_table, &key.elem);
 	lock_release(&thread_current()->sp_lock);
-	return NULL;
+	return e != NULL ? hash_entry(e, struct sup_page, elem) : NULL;
 }
-/*add the supplement page when the thread's execution file.*/
+/*first step of evicting the CNT victim frames VICTS, with frame_lock
+  held.  The dirty bit decides what an eviction costs:
+   - a clean page of a file backed region is dropped and reloaded from
+     the file later, with no I/O;
+   - a dirty memory mapped page is written back to its file;
+   - everything else is written to the swap disk, in one batch.
+  Every victim is unmapped now.  Those to be written get a supplement
+  page in SPS, in transit until finish_sp(), so that a fault on the
+  page waits for the write instead of reading stale data. */
 bool
-add_exefile_sp(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable, bool mmapFlag)
+add_new_sp(struct frame **victs, size_t cnt, struct sup_page **sps)
 {
-	struct sup_page *sp = (struct sup_page *)malloc(sizeof(struct sup_page));
-	if(sp == NULL)
-		return false;
-	lock_acquire(&thread_current()->sp_lock);
-	sp->fd = file->fd;
-	sp->file = file;
-	sp->ofs = ofs;
-	sp->upage = upage;
-	sp->read_bytes = read_bytes;
-	sp->zero_bytes = zero_bytes;
-	sp->writable = writable;
-	sp->ss = NULL;
-	sp->swapped = false;
-	sp->mmapFlag = mmapFlag;
-	list_push_back(&thread_current()->sp_table, &sp->elem);
-	lock_release(&thread_current()->sp_lock);
+	size_t i;
+	ASSERT(cnt <= SWAP_BATCH);
+	for(i = 0; i < cnt; i++)
+	{
+		struct thread *t = victs[i]->t;
+		bool dirty = pagedir_is_dirty(t->pagedir, victs[i]->page_addr);
+		sps[i] = NULL;
+		if(!dirty && find_vma(t, victs[i]->page_addr) != NULL)
+			continue;
+		sps[i] = (struct sup_page *)malloc(sizeof(struct sup_page));
+		if(sps[i] == NULL)
+			goto fail;
+		sps[i]->upage = victs[i]->page_addr;
+		sps[i]->slot = SWAP_ERROR;
+		sps[i]->writable = victs[i]->writable;
+		sps[i]->transit = victs[i];
+	}
+	for(i = 0; i < cnt; i++)
+	{
+		struct thread *t = victs[i]->t;
+		lock_acquire(&t->sp_lock);
+		if(sps[i] != NULL)
+			hash_insert(&t->sp_table, &sps[i]->elem);
+		pagedir_clear_page (t->pagedir, victs[i]->page_addr);
+		lock_release(&t->sp_lock);
+	}
 	return true;
+
+ fail:
+	while(i-- > 0)
+		free(sps[i]);
+	return false;
 }
 
-/*add the supplement page when swap*/
+/*second step, without frame_lock: write out the victims that have a
+  supplement page in SPS, memory mapped ones to their file and the rest
+  to the swap disk in one batch.  False if the swap disk is full. */
 bool
-add_new_sp(struct frame *f)
+write_sp(struct frame **victs, struct sup_page **sps, size_t cnt)
 {
-	struct thread *t = f->t;
-	struct sup_page *sp = (struct sup_page *)malloc(sizeof(struct sup_page));
-	if(sp == NULL)
-		return false;
-	lock_acquire(&thread_current()->sp_lock);
-	sp->upage = f->page_addr;
-	sp->ss = swap_out(f->frame_addr);
-	sp->writable = f->writable;
-	sp->swapped = true;
-	if(sp->ss == NULL)
+	void *pages[SWAP_BATCH];
+	size_t slots[SWAP_BATCH];
+	size_t i, n = 0;
+	for(i = 0; i < cnt; i++)
+	{
+		if(sps[i] == NULL)
+			continue;
+		if(victs[i]->mmapFlag)
+			file_write_at (victs[i]->file, victs[i]->frame_addr, victs[i]->read_bytes, victs[i]->ofs);
+		else
+			pages[n++] = victs[i]->frame_addr;
+	}
+	if(n > 0 && !swap_out_batch(pages, slots, n))
 		return false;
-	list_push_back(&t->sp_table, &sp->elem);
-	pagedir_clear_page (t->pagedir, sp->upage);
-	lock_release(&thread_current()->sp_lock);
+	for(i = 0, n = 0; i < cnt; i++)
+		if(sps[i] != NULL && !victs[i]->mmapFlag)
+			sps[i]->slot = slots[n++];
 	return true;
 }
 
-/*load the thread's exefile */
-bool
-load_exefile(struct sup_page *sp)
+/*last step, with frame_lock held again.  A page now on the swap disk
+  keeps its supplement page, out of transit; one written back to its
+  mapped file loses it.  If SWAPPED is false the swap disk was full, and
+  the pages meant for it are mapped back, dirty, keeping their frames.
+  Leaves the frames evicted in VICTS and returns their number. */
+size_t
+finish_sp(struct frame **victs, struct sup_page **sps, size_t cnt, bool swapped)
 {
-  void *kpage = frame_allocate_zeroflag(sp->upage, sp->mmapFlag, sp->writable, false);
-  if (kpage == NULL)
-    	return false;
-    lock_acquire(&thread_current()->sp_lock);
-    if (file_read_at (sp->file, kpage, sp->read_bytes, sp->ofs) != (int) sp->read_bytes)
+	size_t i, n = 0;
+	for(i = 0; i < cnt; i++)
+	{
+		struct frame *f = victs[i];
+		struct sup_page *sp = sps[i];
+		struct thread *t = f->t;
+		bool evicted = true;
+		if(sp != NULL)
+		{
+			lock_acquire(&t->sp_lock);
+			if(f->mmapFlag || !swapped)
+			{
+				hash_delete(&t->sp_table, &sp->elem);
+				free(sp);
+				if(!f->mmapFlag)
+				{
+					pagedir_set_page(t->pagedir, f->page_addr, f->frame_addr, f->writable);
+					pagedir_set_dirty(t->pagedir, f->page_addr, true);
+					evicted = false;
+				}
+			}
+			else
+				sp->transit = NULL;
+			lock_release(&t->sp_lock);
+		}
+		if(evicted)
+			victs[n++] = f;
+	}
+	return n;
+}
+
+/*read the page UPAGE of the region V into the frame KPAGE and map
+  it.  The frame is freed on failure.  The frame is the thread's own
+  until mapped, so the read is done without sp_lock (see frame.h). */
+static bool
+map_exefile(struct vma *v, void *upage, void *kpage)
+{
+    uint32_t read_bytes = vma_page_read_bytes(v, upage);
+    if (file_read_at (v->file, kpage, read_bytes, vma_page_ofs(v, upage)) != (int) read_bytes)
     {
     	delete_single_frame(kpage);
-    	lock_release(&thread_current()->sp_lock);
     	return false; 
     }
-    lock_release(&thread_current()->sp_lock);
-    memset (kpage + sp->read_bytes, 0, sp->zero_bytes);
-    bool success = (pagedir_get_page (thread_current()->pagedir, sp->upage) == NULL
-          && pagedir_set_page (thread_current()->pagedir, sp->upage, kpage, sp->writable));
+    memset (kpage + read_bytes, 0, PGSIZE - read_bytes);
+    bool success = (pagedir_get_page (thread_current()->pagedir, upage) == NULL
+          && pagedir_set_page (thread_current()->pagedir, upage, kpage, v->writable));
 	if(!success)
 	{
 		delete_single_frame(kpage);
 		return false;
 	}
-	if(sp->writable)
-	  {
-	    remove_sp(sp);
-	  }
-	
     return true;
 }
 
-/* load page to frame from swap disk */
+/*count the pages of the last read-ahead window of T that the process
+  touched, and return that count.  A page evicted in the meantime is
+  not counted. */
+static size_t
+count_ra_hits(struct thread *t)
+{
+	uint8_t *upage;
+	size_t hits = 0;
+	for(upage = t->ra_start; upage < (uint8_t *)t->ra_next; upage += PGSIZE)
+		if(pagedir_get_page(t->pagedir, upage) != NULL
+		   && pagedir_is_accessed(t->pagedir, upage))
+			hits++;
+	ra_hit_cnt += hits;
+	t->ra_start = t->ra_next = NULL;
+	return hits;
+}
+
+/*adapt the read-ahead window to a fault at UPAGE of the region V.  A
+  fault right past the last window, after the whole window was used,
+  is sequential access and doubles the window; any other fault shrinks
+  it back.  Regions advised MADV_RANDOM are not read ahead at all and
+  MADV_SEQUENTIAL ones always with the largest window. */
+static void
+adapt_ra_window(struct thread *t, struct vma *v, void *upage)
+{
+	size_t window = ((uint8_t *)t->ra_next - (uint8_t *)t->ra_start) / PGSIZE;
+	bool next = upage == t->ra_next;
+	size_t hits = count_ra_hits(t);
+	if(v->advice == MADV_RANDOM)
+		t->ra_window = 0;
+	else if(v->advice == MADV_SEQUENTIAL)
+		t->ra_window = RA_WINDOW_MAX;
+	else if(!next || window == 0 || hits < window)
+		t->ra_window = RA_WINDOW_MIN;
+	else if(t->ra_window < RA_WINDOW_MAX)
+		t->ra_window *= 2;
+}
+
+/*map up to the read-ahead window of pages of V following UPAGE that
+  are not loaded yet.  Stops at the first page that is loaded, swapped
+  out or all zero, or when no frame is free without eviction. */
+static void
+read_ahead(struct vma *v, void *upage)
+{
+	struct thread *t = thread_current();
+	uint8_t *next = (uint8_t *)upage + PGSIZE;
+	size_t i;
+	t->ra_start = next;
+	for(i = 0; i < t->ra_window && next < v->end; i++, next += PGSIZE)
+	{
+		void *kpage;
+		if(pagedir_get_page(t->pagedir, next) != NULL
+		   || find_sp(&t->sp_table, next) != NULL
+		   || vma_page_read_bytes(v, next) == 0)
+			break;
+		kpage = frame_try_allocate(next, v->mmapFlag, v->writable);
+		if(kpage == NULL || !map_exefile(v, next, kpage))
+			break;
+		ra_page_cnt++;
+	}
+	t->ra_next = next;
+}
+
+/*on a fault at UPAGE of the region V, accessed sequentially, let the
+  pages one read-ahead window behind the last one go first on eviction:
+  the process is done with them. */
+static void
+drop_behind(struct vma *v, void *upage)
+{
+	uint8_t *end = (uint8_t *)upage - RA_WINDOW_MAX * PGSIZE;
+	uint8_t *start = end - RA_WINDOW_MAX * PGSIZE;
+	if(end <= v->start)
+		return;
+	frame_mark_cold(start > v->start ? start : v->start, end);
+}
+
+/*on a fault at UPAGE of the region V, accessed at random, let the page
+  of the previous such fault go first on eviction unless it is used
+  again before: pages accessed at random are seldom reused. */
+static void
+drop_random(struct vma *v, void *upage)
+{
+	struct thread *t = thread_current();
+	if(t->random_last != NULL && find_vma(t, t->random_last) == v)
+		frame_mark_cold(t->random_last, (uint8_t *)t->random_last + PGSIZE);
+	t->random_last = upage;
+}
+
+/*load the page UPAGE of the file backed region V, with the following
+  pages of the region read ahead */
+bool
+load_exefile(struct vma *v, void *upage)
+{
+  void *kpage = frame_allocate_zeroflag(upage, v->mmapFlag, v->writable, false);
+  if (kpage == NULL)
+    	return false;
+  if (!map_exefile(v, upage, kpage))
+	return false;
+  exe_fault_cnt++;
+  adapt_ra_window(thread_current(), v, upage);
+  if(v->advice == MADV_SEQUENTIAL)
+    drop_behind(v, upage);
+  else if(v->advice == MADV_RANDOM)
+    drop_random(v, upage);
+  read_ahead(v, upage);
+  return true;
+}
+
+/* load page to frame from swap disk.  The page is marked dirty, its
+   only copy left the swap disk. */
 bool
 load_swap(struct sup_page *sp)
 {
-  void *kpage = frame_allocate(sp->upage, false,sp->writable);
+  void *kpage = frame_allocate_zeroflag(sp->upage, false, sp->writable, false);
   if(kpage == NULL)
     return false;
+  return map_swap(sp, kpage);
+}
+
+/*read the swapped out page of SP into the frame KPAGE and map it.  The
+  frame is freed on failure. */
+static bool
+map_swap(struct sup_page *sp, void *kpage)
+{
+  swap_in(kpage, sp->slot);
   bool success = (pagedir_get_page (thread_current()->pagedir, sp->upage) == NULL
 		  && pagedir_set_page (thread_current()->pagedir, sp->upage, kpage, sp->writable));
   if(!success)
@@ -127,43 +342,250 @@ load_swap(struct sup_page *sp)
       delete_single_frame(kpage);
       return false;
     }
-  swap_in(kpage, sp->ss);
+  pagedir_set_dirty (thread_current()->pagedir, sp->upage, true);
   remove_sp(sp);
   return true;
 }
 
-/* load the supplement page */
+/* load the page UPAGE of the current process, from the swap disk or
+   from the region describing it.  Fails if UPAGE is neither, or on a
+   WRITE to a read-only page.  The path taken is stored in CLS. */
 bool
-load_sp(struct sup_page *sp)
+load_page(void *upage, bool write, enum fault_class *cls)
 {
-	if(sp->swapped)
-		return load_swap(sp);
-	else
-		return load_exefile(sp);
+	struct thread *t = thread_current();
+	struct sup_page *sp = find_sp(&t->sp_table, upage);
+	struct vma *v;
+	if(sp != NULL)
+	{
+		/* the page may still be in transit; if the swap disk was
+		   full it is mapped back */
+		sp = frame_wait_page(upage);
+		if(pagedir_get_page(t->pagedir, upage) != NULL)
+		{
+			*cls = FAULT_SWAP;
+			return true;
+		}
+	}
+	if(sp != NULL)
+	{
+		*cls = FAULT_SWAP;
+		return (!write || sp->writable) && load_swap(sp);
+	}
+	v = find_vma(t, upage);
+	if(v == NULL || (write && !v->writable))
+		return false;
+	if(frame_map_large(v, upage))
+	{
+		*cls = FAULT_LARGE;
+		return true;
+	}
+	/* a page with nothing to read is zero until written */
+	if(!write && vma_page_read_bytes(v, upage) == 0)
+	{
+		*cls = FAULT_ZERO;
+		return frame_map_zero(upage);
+	}
+	*cls = v->mmapFlag ? FAULT_MMAP : FAULT_EXE;
+	return load_exefile(v, upage);
 }
 /*remove the supplement page in the supplement table and free it*/
 void
 remove_sp(struct sup_page *sp)
 {
   lock_acquire(&thread_current()->sp_lock);
-  list_remove(&sp->elem);
+  hash_delete(&thread_current()->sp_table, &sp->elem);
   free(sp);
   lock_release(&thread_current()->sp_lock);
 }
+
+/*copy the swapped out pages of PARENT to the current thread, its
+  child being forked.  Each copy gets a slot of its own. */
+bool
+fork_spt(struct thread *parent)
+{
+	struct thread *t = thread_current();
+	struct hash_iterator i;
+	bool success = true;
+	void *buffer = palloc_get_page(0);
+	if(buffer == NULL)
+		return false;
+	lock_acquire(&parent->sp_lock);
+	hash_first(&i, &parent->sp_table);
+	while(success && hash_next(&i))
+	{
+		struct sup_page *psp = hash_entry(hash_cur(&i), struct sup_page, elem);
+		struct sup_page *sp;
+		/* only memory mapped pages, not inherited, can be in transit
+		   once frame_fork() made the others shared */
+		if(psp->transit != NULL)
+			continue;
+		sp = (struct sup_page *)malloc(sizeof(struct sup_page));
+		if(sp == NULL)
+		{
+			success = false;
+			break;
+		}
+		swap_read(buffer, psp->slot);
+		sp->upage = psp->upage;
+		sp->writable = psp->writable;
+		sp->transit = NULL;
+		sp->slot = swap_out(buffer);
+		if(sp->slot == SWAP_ERROR)
+		{
+			free(sp);
+			success = false;
+			break;
+		}
+		lock_acquire(&t->sp_lock);
+		hash_insert(&t->sp_table, &sp->elem);
+		lock_release(&t->sp_lock);
+	}
+	lock_release(&parent->sp_lock);
+	palloc_free_page(buffer);
+	return success;
+}
+
+/*free the supplement page, used when the table is destroyed*/
+static void
+sp_destroy(struct hash_elem *e, void *aux UNUSED)
+{
+	struct sup_page *sp = hash_entry(e, struct sup_page, elem);
+	set_free_slot(sp->slot, 1);
+	free(sp);
+}
+
 /*when sys_exit, destroy the supplement page table */
 void
 destroy_spt(struct thread *t)
 {
-	struct list_elem *e;
-	struct sup_page *sp;
+	count_ra_hits(t);
 	remove_thread_frame(t);
 	lock_acquire(&thread_current()->sp_lock);
-	while(!list_empty(&t->sp_table))
+	hash_destroy(&t->sp_table, sp_destroy);
+	lock_release(&thread_current()->sp_lock);
+	destroy_vma(t);
+}
+
+/*bring in the page UPAGE of the current thread ahead of its use, from
+  the swap disk or from its region.  Like read-ahead it never evicts.
+  False when no frame is left; pages with nothing to read are skipped. */
+static bool
+prefetch_page(void *upage)
+{
+	struct thread *t = thread_current();
+	struct sup_page *sp = NULL;
+	struct vma *v;
+	void *kpage;
+	if(find_sp(&t->sp_table, upage) != NULL)
+		sp = frame_wait_page(upage);
+	if(pagedir_get_page(t->pagedir, upage) != NULL)
+		return true;
+	if(sp != NULL)
 	{
-		sp = list_entry(list_pop_front(&t->sp_table), struct sup_page, elem);
-		if(sp->swapped)
-			set_free_slot(sp->ss);
-		free(sp);
+		kpage = frame_try_allocate(upage, false, sp->writable);
+		if(kpage == NULL || !map_swap(sp, kpage))
+			return false;
+		prefetch_cnt++;
+		return true;
 	}
-	lock_release(&thread_current()->sp_lock);
+	v = find_vma(t, upage);
+	if(v == NULL || vma_page_read_bytes(v, upage) == 0)
+		return true;
+	if(frame_map_large(v, upage))
+		return true;
+	kpage = frame_try_allocate(upage, v->mmapFlag, v->writable);
+	if(kpage == NULL || !map_exefile(v, upage, kpage))
+		return false;
+	prefetch_cnt++;
+	return true;
+}
+
+/*drop the pages of the current thread from START to END, resident or
+  swapped out.  They come back from their region, or zero filled, on
+  the next fault. */
+static void
+discard_pages(uint8_t *start, uint8_t *end)
+{
+	struct thread *t = thread_current();
+	uint8_t *upage;
+	discard_cnt += frame_discard(start, end);
+	for(upage = start; upage < end; upage += PGSIZE)
+	{
+		struct sup_page *sp;
+		if(find_sp(&t->sp_table, upage) == NULL)
+			continue;
+		sp = frame_wait_page(upage);
+		if(sp == NULL)
+			continue;
+		set_free_slot(sp->slot, 1);
+		remove_sp(sp);
+		discard_cnt++;
+	}
+}
+
+/*true if the LEN bytes at ADDR are user memory and ADDR is page
+  aligned.  END is set to the page just past them. */
+static bool
+user_range(void *addr, size_t len, uint8_t **end)
+{
+	if(pg_ofs(addr) != 0 || !is_user_vaddr(addr)
+	   || len > (size_t)((uint8_t *)PHYS_BASE - (uint8_t *)addr))
+		return false;
+	*end = pg_round_up((uint8_t *)addr + len);
+	return true;
+}
+
+/*apply madvise() ADVICE to the LEN bytes at ADDR of the current
+  thread.  MADV_NORMAL, MADV_RANDOM and MADV_SEQUENTIAL set the access
+  pattern of the regions in the range, MADV_WILLNEED prefetches its
+  pages and MADV_DONTNEED drops them.  False if ADDR is not page
+  aligned, the range is not user memory or ADVICE is unknown. */
+bool
+page_advise(void *addr, size_t len, int advice)
+{
+	uint8_t *start = addr;
+	uint8_t *end, *upage;
+	if(!user_range(addr, len, &end))
+		return false;
+	switch(advice)
+	{
+	case MADV_NORMAL:
+	case MADV_RANDOM:
+	case MADV_SEQUENTIAL:
+		advise_vma(start, end, advice);
+		return true;
+	case MADV_WILLNEED:
+		for(upage = start; upage < end; upage += PGSIZE)
+			if(!prefetch_page(upage))
+				break;
+		return true;
+	case MADV_DONTNEED:
+		discard_pages(start, end);
+		return true;
+	}
+	return false;
+}
+
+/*msync(): write the dirty memory mapped pages among the LEN bytes at
+  ADDR of the current thread back to their files, keeping them mapped.
+  False if ADDR is not page aligned or the range is not user memory. */
+bool
+page_msync(void *addr, size_t len)
+{
+	uint8_t *end;
+	if(!user_range(addr, len, &end))
+		return false;
+	frame_msync(addr, end);
+	return true;
+}
+
+/*print the statistics of faults on file backed pages */
+void
+page_print_stats(void)
+{
+	printf("Page: %lld file faults, %lld pages read ahead, %lld read-ahead hits\n",
+		exe_fault_cnt, ra_page_cnt, ra_hit_cnt);
+	printf("Page: %lld pages prefetched, %lld discarded\n",
+		prefetch_cnt, discard_cnt);
 }
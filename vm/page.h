@@ -2,36 +2,45 @@
 #define VM_PAGE_H
 #include "threads/thread.h"
 #include <list.h>
+#include <hash.h>
 #include "filesys/off_t.h"
+#include <vmstat.h>
+#include <mman.h>
 
 /* Project 3: additional code */
+struct frame;
+struct vma;
+
+/* A page written to the swap disk.  Pages of file backed regions that
+   are still described by their file have no supplement page.  While
+   an eviction writes the page out, to the swap disk or to its mapped
+   file, TRANSIT is the frame it is written from. */
 struct sup_page
 {
   void *upage;     	   /*virtual address*/
-  struct swap_slot *ss;    /*disk memory slot*/
+  size_t slot;             /*swap slot index*/
   bool writable;           /*writable*/
-  int fd;                  /*file descripter*/
+  struct frame *transit;   /*frame in transit, NULL once written*/
  
-  struct list_elem elem;   
-  
-  bool swapped;            /*should swap or not*/
-  bool mmapFlag;           /*mmap or not */
-  struct file *file;       /*file*/
-  uint32_t ofs;            /*position to start reading or writing for page */
-  uint32_t read_bytes;     /*reading size for page*/
-  uint32_t zero_bytes;     /*zero_bytes for page */
+  struct hash_elem elem;      /*element of the supplement table*/
 };
 
 
-struct sup_page *find_sp(struct list *sp_table, void *upage);
-bool add_exefile_sp(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable, bool mmapFlag);
+bool init_spt(struct thread *t);
+struct sup_page *find_sp(struct hash *sp_table, void *upage);
 
-bool load_exefile(struct sup_page *sp);
+bool load_exefile(struct vma *v, void *upage);
 bool load_swap(struct sup_page *sp);
  
-bool add_new_sp(struct frame *f);
-bool load_sp(struct sup_page *sp);
+bool add_new_sp(struct frame **victs, size_t cnt, struct sup_page **sps);
+bool write_sp(struct frame **victs, struct sup_page **sps, size_t cnt);
+size_t finish_sp(struct frame **victs, struct sup_page **sps, size_t cnt, bool swapped);
+bool load_page(void *upage, bool write, enum fault_class *cls);
 void remove_sp(struct sup_page *sp);
+bool fork_spt(struct thread *parent);
 void destroy_spt(struct thread *t);
+bool page_advise(void *addr, size_t len, int advice);
+bool page_msync(void *addr, size_t len);
+void page_print_stats(void);
 
 #endif /* vm/page.h */
@@ -1,6 +1,7 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/swap.h"
+#include "vm/zswap.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
 #include "threads/thread.h"
@@ -9,91 +10,154 @@
 #include "threads/synch.h"
 #include "userprog/pagedir.h"
 #include <stdio.h>
-#include <list.h>
+#include <bitmap.h>
 #include "devices/disk.h"
 
 struct disk *swap_disk;
-struct list free_swap_list;
-disk_sector_t slot_max;
-disk_sector_t slot_count;
+struct bitmap *swap_map;		/* one bit per swap slot, true if used */
 struct lock swap_lock;
+long long swap_batch_cnt;		/* number of disk write commands */
+long long swap_out_cnt;			/* number of pages written to the disk */
+long long swap_in_cnt;			/* number of pages read */
 #define PAGE_SECTOR_NUM (PGSIZE/DISK_SECTOR_SIZE)		/* number of sectors in one page */
 
 /*initialize the swap */
 void
 swap_init(void)
 {
-	list_init(&free_swap_list);
+	size_t slot_max = 0;
 	swap_disk = disk_get(1,1); /* disk for swap: (1,1) */
-	slot_max = disk_size(swap_disk);
-	slot_count = 0;
+	if(swap_disk != NULL)
+		slot_max = disk_size(swap_disk) / PAGE_SECTOR_NUM;
+	swap_map = bitmap_create(slot_max);
+	if(swap_map == NULL)
+		PANIC("swap_init: cannot allocate swap bitmap");
 	lock_init(&swap_lock);
+	zswap_init(slot_max);
 }
 
-/*Get the free space of disk */
-struct swap_slot *
-get_free_slot()
+/*reserve CNT contiguous free slots of the disk and return the first,
+  SWAP_ERROR if there is no such run */
+size_t
+get_free_slot(size_t cnt)
 {
-	struct swap_slot *ss;
-	if(list_empty(&free_swap_list))
+	size_t slot;
+	lock_acquire(&swap_lock);
+	slot = bitmap_scan_and_flip(swap_map, 0, cnt, false);
+	lock_release(&swap_lock);
+	return slot;
+}
+/*release CNT slots starting at SLOT */
+void
+set_free_slot(size_t slot, size_t cnt)
+{
+	size_t i;
+	for(i = 0; i < cnt; i++)
+		zswap_drop(slot + i);
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_all(swap_map, slot, cnt));
+	bitmap_set_multiple(swap_map, slot, cnt, false);
+	lock_release(&swap_lock);
+}
+/*write the CNT pages PAGES to the adjacent slots from SLOT, in one
+  command that takes each sector straight from its frame*/
+static void
+swap_write_run(void **pages, size_t slot, size_t cnt)
+{
+	disk_write_vector(swap_disk, slot * PAGE_SECTOR_NUM,
+		(const void *const *)pages, cnt, PAGE_SECTOR_NUM);
+}
+
+/*swap out CNT pages, storing the slot of PAGES[i] in SLOTS[i].  Each
+  page is kept compressed in the zswap pool if it can be; the others
+  are written to the disk.  The pages go to adjacent slots when such a
+  run is free, and then each run of them between pages kept in the
+  pool is written with a single disk command.  Only when the slots had
+  to be found one at a time is each page written on its own.  Returns
+  false if the disk is full. */
+bool
+swap_out_batch(void **pages, size_t *slots, size_t cnt)
+{
+	bool to_disk[SWAP_BATCH];
+	size_t i, j, n, cmds, first;
+	ASSERT(cnt <= SWAP_BATCH);
+	first = get_free_slot(cnt);
+	for(i = 0; i < cnt; i++)
 	{
-		if((slot_count + PAGE_SECTOR_NUM) > slot_max)
+		slots[i] = first != SWAP_ERROR ? first + i : get_free_slot(1);
+		if(slots[i] == SWAP_ERROR)
 		{
-			return NULL;
+			while(i-- > 0)
+				set_free_slot(slots[i], 1);
+			return false;
 		}
-		ss = (struct swap_slot *)malloc(sizeof(struct swap_slot));
-		ss->sec_no = slot_count;
-		slot_count += PAGE_SECTOR_NUM;
 	}
-	else
-		ss = list_entry(list_pop_front(&free_swap_list), struct swap_slot, elem);
-	return ss;
+	for(i = 0; i < cnt; i++)
+		to_disk[i] = !zswap_store(slots[i], pages[i]);
+	for(i = 0, n = 0, cmds = 0; i < cnt; i = j)
+	{
+		j = i + 1;
+		if(!to_disk[i])
+			continue;
+		if(first != SWAP_ERROR)
+			while(j < cnt && to_disk[j])
+				j++;
+		swap_write_run(pages + i, slots[i], j - i);
+		n += j - i;
+		cmds++;
+	}
+	if(n > 0)
+	{
+		lock_acquire(&swap_lock);
+		swap_batch_cnt += cmds;
+		swap_out_cnt += n;
+		lock_release(&swap_lock);
+	}
+	return true;
 }
-/*push back the free swap slot to the list */
+/*write PAGE to the slot SLOT of the disk, in one command */
 void
-set_free_slot(struct swap_slot *ss)
+swap_write(const void *page, size_t slot)
 {
-	list_push_back(&free_swap_list, &ss->elem);
+	swap_write_run((void **)&page, slot, 1);
 }
 /*swap out */
-struct swap_slot *
+size_t
 swap_out(void *buffer)
 {
-	void *sec_buff = malloc(DISK_SECTOR_SIZE);
-	ASSERT(sec_buff != NULL);
-	lock_acquire(&swap_lock);
-	struct swap_slot *ss = get_free_slot();
-	if(ss == NULL)
-	{
-		lock_release(&swap_lock);
-		return NULL;
-	}
-	disk_sector_t sec_no = ss->sec_no;
-	int i;
-	for(i = 0; i<PAGE_SECTOR_NUM; i++)
-	{
-		memcpy(sec_buff, (uint8_t *)((uint32_t)buffer + DISK_SECTOR_SIZE*i),DISK_SECTOR_SIZE);
-		disk_write(swap_disk, (disk_sector_t)(sec_no + i), sec_buff);
-	}
-	free(sec_buff);
-	lock_release(&swap_lock);
-	return ss;
+	size_t slot;
+	if(!swap_out_batch(&buffer, &slot, 1))
+		return SWAP_ERROR;
+	return slot;
+}
+/*read the slot SLOT into BUFFER, from the zswap pool or the disk,
+  keeping the slot */
+void
+swap_read(void *buffer, size_t slot)
+{
+	if(zswap_load(slot, buffer))
+		return;
+	disk_read_multiple(swap_disk, slot * PAGE_SECTOR_NUM, PAGE_SECTOR_NUM, buffer);
 }
 /*swap in */
 void
-swap_in(void *buffer, struct swap_slot *ss)
+swap_in(void *buffer, size_t slot)
 {
-	void *sec_buff = malloc(DISK_SECTOR_SIZE);
-	ASSERT(sec_buff != NULL);
+	swap_read(buffer, slot);
 	lock_acquire(&swap_lock);
-	disk_sector_t sec_no = ss->sec_no;
-	int i;
-	for(i = 0; i<PAGE_SECTOR_NUM; i++)
-	{
-		disk_read(swap_disk, (disk_sector_t)(sec_no + i), sec_buff);
-		memcpy((uint8_t *)((uint32_t)buffer + DISK_SECTOR_SIZE*i), sec_buff, DISK_SECTOR_SIZE);
-	}
-	set_free_slot(ss);
-	free(sec_buff);
+	swap_in_cnt++;
 	lock_release(&swap_lock);
+	set_free_slot(slot, 1);
+}
+
+/*print the statistics of swap */
+void
+swap_print_stats(void)
+{
+	printf("Swap: %lld write commands, %lld pages (%lld sectors) written, %lld pages read\n",
+		swap_batch_cnt, swap_out_cnt, swap_out_cnt * PAGE_SECTOR_NUM, swap_in_cnt);
+	if(swap_batch_cnt > 0)
+		printf("Swap: %lld pages, %lld sectors per write command\n",
+			swap_out_cnt / swap_batch_cnt, swap_out_cnt * PAGE_SECTOR_NUM / swap_batch_cnt);
+	zswap_print_stats();
 }
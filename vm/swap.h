@@ -1,18 +1,21 @@
 #ifndef VM_SWAP_H
 #define VM_SWAP_H
 #include "threads/thread.h"
-#include <list.h>
+#include <bitmap.h>
 
-struct swap_slot
-{
-	uint32_t sec_no;			/* sector number of free swap slot in disk */
-	struct list_elem elem;
-};
+/* Swap slots are page-sized runs of sectors on the swap disk,
+   identified by their index.  A free slot is one clear bit. */
+#define SWAP_ERROR BITMAP_ERROR		/* no free swap slot */
+#define SWAP_BATCH 4			/* max victims written in one batch */
 
 void swap_init(void);
-struct swap_slot *get_free_slot();
-void set_free_slot(struct swap_slot *ss);
-struct swap_slot *swap_out(void *buffer);
-void swap_in(void *buffer, struct swap_slot *ss);
+size_t get_free_slot(size_t cnt);
+void set_free_slot(size_t slot, size_t cnt);
+bool swap_out_batch(void **pages, size_t *slots, size_t cnt);
+size_t swap_out(void *buffer);
+void swap_write(const void *page, size_t slot);
+void swap_read(void *buffer, size_t slot);
+void swap_in(void *buffer, size_t slot);
+void swap_print_stats(void);
 
 #endif /* vm/swap.h */
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "vm/vma.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "threads/synch.h"
+#include "filesys/file.h"
+#include <list.h>
+#include <mman.h>
+
+static bool vma_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+
+/*order of the regions, by the first page*/
+static bool
+vma_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct vma, elem)->start < list_entry(b, struct vma, elem)->start;
+}
+
+/*add a region of READ_BYTES + ZERO_BYTES bytes at UPAGE, of which the
+  first READ_BYTES are read from FILE at OFS.  Fails if the region
+  overlaps one the thread already has. */
+bool
+add_vma(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable, bool mmapFlag)
+{
+	struct thread *t = thread_current();
+	struct list_elem *e;
+	struct vma *v = (struct vma *)malloc(sizeof(struct vma));
+	if(v == NULL)
+		return false;
+	v->start = upage;
+	v->end = upage + read_bytes + zero_bytes;
+	v->file = file;
+	v->ofs = ofs;
+	v->read_bytes = read_bytes;
+	v->writable = writable;
+	v->mmapFlag = mmapFlag;
+	v->fd = file->fd;
+	v->advice = MADV_NORMAL;
+	list_init(&v->frames);
+	lock_acquire(&t->sp_lock);
+	for(e = list_begin(&t->vma_list); e != list_end(&t->vma_list); e = list_next(e))
+	{
+		struct vma *o = list_entry(e, struct vma, elem);
+		if(o->start < v->end && v->start < o->end)
+		{
+			lock_release(&t->sp_lock);
+			free(v);
+			return false;
+		}
+	}
+	list_insert_ordered(&t->vma_list, &v->elem, vma_less, NULL);
+	lock_release(&t->sp_lock);
+	return true;
+}
+
+/*find the region of T containing UPAGE, NULL if there is none*/
+struct vma *
+find_vma(struct thread *t, void *upage)
+{
+	struct list_elem *e;
+	struct vma *found = NULL;
+	lock_acquire(&t->sp_lock);
+	for(e = list_begin(&t->vma_list); e != list_end(&t->vma_list); e = list_next(e))
+	{
+		struct vma *v = list_entry(e, struct vma, elem);
+		if((uint8_t *)upage < v->start)
+			break;
+		if((uint8_t *)upage < v->end)
+		{
+			found = v;
+			break;
+		}
+	}
+	lock_release(&t->sp_lock);
+	return found;
+}
+
+/*file offset of the page UPAGE of V*/
+off_t
+vma_page_ofs(struct vma *v, void *upage)
+{
+	return v->ofs + ((uint8_t *)upage - v->start);
+}
+
+/*bytes of the page UPAGE of V read from the file, the rest is zero*/
+uint32_t
+vma_page_read_bytes(struct vma *v, void *upage)
+{
+	uint32_t skip = (uint8_t *)upage - v->start;
+	if(skip >= v->read_bytes)
+		return 0;
+	return v->read_bytes - skip < PGSIZE ? v->read_bytes - skip : PGSIZE;
+}
+
+/*remove the memory mapped regions of file FD.  The resident pages
+  must have been unmapped with unmap_frames() first. */
+void
+remove_vma(int fd)
+{
+	struct thread *t = thread_current();
+	struct list_elem *e;
+	lock_acquire(&t->sp_lock);
+	for(e = list_begin(&t->vma_list); e != list_end(&t->vma_list);)
+	{
+		struct vma *v = list_entry(e, struct vma, elem);
+		if(v->mmapFlag && v->fd == fd)
+		{
+			ASSERT(list_empty(&v->frames));
+			e = list_remove(e);
+			free(v);
+		}
+		else
+			e = list_next(e);
+	}
+	lock_release(&t->sp_lock);
+}
+
+/*set the access pattern ADVICE of the regions of the current thread
+  overlapping START to END.  A region takes the advice as a whole. */
+void
+advise_vma(uint8_t *start, uint8_t *end, int advice)
+{
+	struct thread *t = thread_current();
+	struct list_elem *e;
+	lock_acquire(&t->sp_lock);
+	for(e = list_begin(&t->vma_list); e != list_end(&t->vma_list); e = list_next(e))
+	{
+		struct vma *v = list_entry(e, struct vma, elem);
+		if(v->start >= end)
+			break;
+		if(start < v->end)
+			v->advice = advice;
+	}
+	lock_release(&t->sp_lock);
+}
+
+/*copy the regions of PARENT to the current thread, its child being
+  forked.  The segments of the executable are read from EXEC_FILE, the
+  child's own handle; memory mapped files are not inherited. */
+bool
+fork_vma(struct thread *parent, struct file *exec_file)
+{
+	struct thread *t = thread_current();
+	struct list_elem *e;
+	for(e = list_begin(&parent->vma_list); e != list_end(&parent->vma_list); e = list_next(e))
+	{
+		struct vma *pv = list_entry(e, struct vma, elem);
+		struct vma *v;
+		if(pv->mmapFlag)
+			continue;
+		v = (struct vma *)malloc(sizeof(struct vma));
+		if(v == NULL)
+			return false;
+		*v = *pv;
+		v->file = exec_file;
+		list_init(&v->frames);
+		lock_acquire(&t->sp_lock);
+		list_push_back(&t->vma_list, &v->elem);
+		lock_release(&t->sp_lock);
+	}
+	return true;
+}
+
+/*free all the regions of T, when it exits*/
+void
+destroy_vma(struct thread *t)
+{
+	lock_acquire(&t->sp_lock);
+	while(!list_empty(&t->vma_list))
+		free(list_entry(list_pop_front(&t->vma_list), struct vma, elem));
+	lock_release(&t->sp_lock);
+}
@@ -0,0 +1,36 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include "threads/thread.h"
+#include <list.h>
+#include "filesys/off_t.h"
+
+/* A region of user virtual memory backed by a file, an ELF segment
+   or a memory mapped file.  One record describes the whole region and
+   its pages are read on demand. */
+struct vma
+{
+  uint8_t *start;          /*first page of the region*/
+  uint8_t *end;            /*page just past the region*/
+  struct file *file;       /*backing file*/
+  off_t ofs;               /*file offset of the first page*/
+  uint32_t read_bytes;     /*bytes read from the file, the rest is zero*/
+  bool writable;           /*writable*/
+  bool mmapFlag;           /*mmap or not*/
+  int fd;                  /*file descripter, also mapID of mmaped files*/
+  int advice;              /*access pattern given to madvise(), MADV_NORMAL,
+                             MADV_RANDOM or MADV_SEQUENTIAL*/
+  struct list frames;      /*resident frames of a mmaped file*/
+
+  struct list_elem elem;   /*element of the thread's vma_list*/
+};
+
+bool add_vma(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable, bool mmapFlag);
+struct vma *find_vma(struct thread *t, void *upage);
+off_t vma_page_ofs(struct vma *v, void *upage);
+uint32_t vma_page_read_bytes(struct vma *v, void *upage);
+void remove_vma(int fd);
+void advise_vma(uint8_t *start, uint8_t *end, int advice);
+bool fork_vma(struct thread *parent, struct file *exec_file);
+void destroy_vma(struct thread *t);
+
+#endif /* vm/vma.h */
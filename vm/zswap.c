@@ -0,0 +1,273 @@
+#include "vm/zswap.h"
+#include "vm/swap.h"
+#include "threads/palloc.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include <stdio.h>
+#include <string.h>
+#include <round.h>
+#include <list.h>
+
+/* A page held compressed in the pool. */
+struct zswap_entry
+{
+  size_t slot;             /*swap slot of the page*/
+  size_t len;              /*bytes of compressed data*/
+  struct list_elem elem;   /*element of zswap_fifo*/
+  uint8_t data[];          /*compressed data*/
+};
+
+/* Pages compressing to more than this are written to the disk, a
+   larger entry would save too little. */
+#define ZSWAP_MAX_LEN (PGSIZE / 4 - sizeof(struct zswap_entry))
+
+/* Codec.  A compressed page is a series of tokens:
+   0LLLLLLL followed by L + 1 literal bytes, or
+   1LLLLLLL followed by a 16 bit offset, copying L + 3 bytes from
+   that many bytes back in the page. */
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS 0x80
+#define LZ_HASH_BITS 12
+
+size_t zswap_pool_pages = 64;		/* pool size, in pages */
+size_t zswap_pool_bytes;		/* bytes of entries in the pool */
+struct zswap_entry **zswap_map;		/* entry of each swap slot, or NULL */
+size_t zswap_slot_cnt;			/* number of entries in zswap_map */
+struct list zswap_fifo;			/* entries, oldest first */
+struct lock zswap_lock;
+
+/* scratch space, under zswap_lock */
+static uint16_t lz_hash[1 << LZ_HASH_BITS];	/* 1 + last position of a hash */
+static uint8_t lz_out[PGSIZE];			/* compressor output */
+void *zswap_buf;				/* page being pushed to disk */
+
+long long zswap_store_cnt;		/* pages stored in the pool */
+long long zswap_comp_bytes;		/* their compressed size */
+long long zswap_reject_cnt;		/* pages that compressed poorly */
+long long zswap_hit_cnt;		/* pages read from the pool */
+long long zswap_push_cnt;		/* entries pushed out to the disk */
+
+static size_t lz_compress(const uint8_t *src, uint8_t *dst, size_t max);
+static void lz_decompress(const uint8_t *src, size_t len, uint8_t *dst);
+static bool lz_literals(const uint8_t *src, size_t cnt, uint8_t *dst, size_t *op, size_t max);
+static void push_entry(struct zswap_entry *e);
+static void remove_entry(struct zswap_entry *e);
+
+/*initialize the pool for SLOT_CNT swap slots*/
+void
+zswap_init(size_t slot_cnt)
+{
+	list_init(&zswap_fifo);
+	lock_init(&zswap_lock);
+	if(zswap_pool_pages == 0 || slot_cnt == 0)
+		return;
+	zswap_map = palloc_get_multiple(PAL_ZERO,
+		DIV_ROUND_UP(slot_cnt * sizeof *zswap_map, PGSIZE));
+	zswap_buf = palloc_get_page(0);
+	if(zswap_map == NULL || zswap_buf == NULL)
+	{
+		printf("zswap: not enough memory, pool disabled\n");
+		return;
+	}
+	zswap_slot_cnt = slot_cnt;
+}
+
+/*hash of the 3 bytes at P*/
+static unsigned
+lz_hash3(const uint8_t *p)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/*append the CNT literal bytes at SRC to DST at *OP, in runs of at most
+  LZ_MAX_LITERALS, advancing *OP.  False if DST would grow past MAX. */
+static bool
+lz_literals(const uint8_t *src, size_t cnt, uint8_t *dst, size_t *op, size_t max)
+{
+	while(cnt > 0)
+	{
+		size_t run = cnt < LZ_MAX_LITERALS ? cnt : LZ_MAX_LITERALS;
+		if(*op + 1 + run > max)
+			return false;
+		dst[(*op)++] = run - 1;
+		memcpy(dst + *op, src, run);
+		*op += run;
+		src += run;
+		cnt -= run;
+	}
+	return true;
+}
+
+/*compress the page SRC into DST.  Returns the compressed length, or
+  0 if it would exceed MAX.  Greedy LZ77 with a one-entry hash chain,
+  a match is found only where the last 3 byte sequence with the same
+  hash started. */
+static size_t
+lz_compress(const uint8_t *src, uint8_t *dst, size_t max)
+{
+	size_t ip = 0, op = 0, lit = 0;
+	memset(lz_hash, 0, sizeof lz_hash);
+	while(ip + LZ_MIN_MATCH <= PGSIZE)
+	{
+		unsigned h = lz_hash3(src + ip);
+		size_t cand = lz_hash[h];
+		size_t len;
+		lz_hash[h] = ip + 1;
+		if(cand == 0 || memcmp(src + cand - 1, src + ip, LZ_MIN_MATCH))
+		{
+			ip++;
+			continue;
+		}
+		cand--;
+		for(len = LZ_MIN_MATCH; ip + len < PGSIZE && len < LZ_MAX_MATCH; len++)
+			if(src[cand + len] != src[ip + len])
+				break;
+		if(!lz_literals(src + lit, ip - lit, dst, &op, max) || op + 3 > max)
+			return 0;
+		dst[op++] = 0x80 | (len - LZ_MIN_MATCH);
+		dst[op++] = (ip - cand) & 0xff;
+		dst[op++] = (ip - cand) >> 8;
+		ip += len;
+		lit = ip;
+	}
+	if(!lz_literals(src + lit, PGSIZE - lit, dst, &op, max))
+		return 0;
+	return op;
+}
+
+/*decompress the LEN bytes at SRC into the page DST*/
+static void
+lz_decompress(const uint8_t *src, size_t len, uint8_t *dst)
+{
+	size_t ip = 0, op = 0;
+	while(ip < len)
+	{
+		uint8_t c = src[ip++];
+		if(c & 0x80)
+		{
+			size_t mlen = (c & 0x7f) + LZ_MIN_MATCH;
+			size_t off = src[ip] | (src[ip + 1] << 8);
+			ip += 2;
+			ASSERT(off > 0 && off <= op && op + mlen <= PGSIZE);
+			/* byte by byte, the copy may overlap its source */
+			for(; mlen > 0; mlen--, op++)
+				dst[op] = dst[op - off];
+		}
+		else
+		{
+			size_t run = c + 1;
+			ASSERT(op + run <= PGSIZE);
+			memcpy(dst + op, src + ip, run);
+			ip += run;
+			op += run;
+		}
+	}
+	ASSERT(op == PGSIZE);
+}
+
+/*take E out of the pool, with zswap_lock held*/
+static void
+remove_entry(struct zswap_entry *e)
+{
+	list_remove(&e->elem);
+	zswap_map[e->slot] = NULL;
+	zswap_pool_bytes -= sizeof *e + e->len;
+	free(e);
+}
+
+/*write E to its slot on the disk and take it out of the pool.  Done
+  with zswap_lock held, so the slot is not read or reused meanwhile. */
+static void
+push_entry(struct zswap_entry *e)
+{
+	lz_decompress(e->data, e->len, zswap_buf);
+	swap_write(zswap_buf, e->slot);
+	zswap_push_cnt++;
+	remove_entry(e);
+}
+
+/*store PAGE, given the swap slot SLOT, compressed in the pool, pushing
+  the oldest entries to the disk to make room.  False if the pool is
+  off or PAGE compresses poorly; the caller writes it to the disk. */
+bool
+zswap_store(size_t slot, const void *page)
+{
+	struct zswap_entry *e;
+	size_t len;
+	if(slot >= zswap_slot_cnt)
+		return false;
+	lock_acquire(&zswap_lock);
+	len = lz_compress(page, lz_out, ZSWAP_MAX_LEN);
+	if(len == 0)
+	{
+		zswap_reject_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	while(!list_empty(&zswap_fifo)
+	      && zswap_pool_bytes + sizeof *e + len > zswap_pool_pages * PGSIZE)
+		push_entry(list_entry(list_front(&zswap_fifo), struct zswap_entry, elem));
+	e = malloc(sizeof *e + len);
+	if(e == NULL)
+	{
+		lock_release(&zswap_lock);
+		return false;
+	}
+	e->slot = slot;
+	e->len = len;
+	memcpy(e->data, lz_out, len);
+	list_push_back(&zswap_fifo, &e->elem);
+	zswap_map[slot] = e;
+	zswap_pool_bytes += sizeof *e + len;
+	zswap_store_cnt++;
+	zswap_comp_bytes += len;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/*read the page of SLOT into PAGE if it is in the pool, keeping it
+  there until the slot is freed*/
+bool
+zswap_load(size_t slot, void *page)
+{
+	struct zswap_entry *e;
+	if(slot >= zswap_slot_cnt)
+		return false;
+	lock_acquire(&zswap_lock);
+	e = zswap_map[slot];
+	if(e != NULL)
+	{
+		lz_decompress(e->data, e->len, page);
+		zswap_hit_cnt++;
+	}
+	lock_release(&zswap_lock);
+	return e != NULL;
+}
+
+/*forget the page of SLOT, its slot being freed*/
+void
+zswap_drop(size_t slot)
+{
+	if(slot >= zswap_slot_cnt)
+		return;
+	lock_acquire(&zswap_lock);
+	if(zswap_map[slot] != NULL)
+		remove_entry(zswap_map[slot]);
+	lock_release(&zswap_lock);
+}
+
+/*print the statistics of the pool*/
+void
+zswap_print_stats(void)
+{
+	if(zswap_store_cnt == 0)
+		return;
+	printf("Zswap: %lld pages compressed to %lld%%, %lld compressed poorly\n",
+		zswap_store_cnt, zswap_comp_bytes * 100 / (zswap_store_cnt * PGSIZE),
+		zswap_reject_cnt);
+	printf("Zswap: %lld pool hits, %lld pushed to disk, %lld disk writes avoided\n",
+		zswap_hit_cnt, zswap_push_cnt, zswap_store_cnt - zswap_push_cnt);
+}
@@ -0,0 +1,18 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Compressed swap pool.  Swapped out pages are kept compressed in
+   kernel memory, under the swap slot they were given, and written
+   to that slot of the swap disk only if they compress poorly or are
+   pushed out of the pool.  Its size is set with -vm-zswap. */
+extern size_t zswap_pool_pages;
+
+void zswap_init(size_t slot_cnt);
+bool zswap_store(size_t slot, const void *page);
+bool zswap_load(size_t slot, void *page);
+void zswap_drop(size_t slot);
+void zswap_print_stats(void);
+
+#endif /* vm/zswap.h */